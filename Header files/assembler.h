@@ -0,0 +1,230 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <setjmp.h>
+#include "errors.h"
+#include "diagnostics.h"
+#include "memory_utility.h"
+#include "input.h"
+#include "mem_image.h"
+#include "interner.h"
+#include "lexer.h"
+#include "tables.h"
+
+/*
+ * File: assembler.h
+ * -----------------
+ * This header defines the assembler context: everything needed to assemble
+ * one source file, from the allocator to the output images. Every phase of
+ * the assembler works on a context instead of process-global state and
+ * reports failure through its return value, so several files can be
+ * assembled in one process, one after another or in parallel threads,
+ * without interfering with each other.
+ *
+ * The assembler can also be used as a library (libassembler): assemble_source
+ * takes the source text from memory and leaves the object words, entries and
+ * externals in the context as plain structs, without touching the filesystem.
+ * The file-based front end (assemble) writes the same results to the .ob,
+ * .ent and .ext files, to the binary .obb file, or to both.
+ *
+ * Types:
+ *  - assembler_symbol: An entry or external reference in the result.
+ *  - assembler_result: The output of a successful assembly.
+ *  - assembler_ctx: The state of one assembly.
+ *
+ * Functions:
+ *  - init_assembler_ctx: Prepares a context for a source file.
+ *  - bind_assembler_ctx: Makes the calling thread allocate and report through a context.
+ *  - assemble: Assembles a source file into the output files.
+ *  - assemble_source: Assembles source text held in memory.
+ *  - release_assembler_ctx: Releases the memory owned by a context.
+ */
+
+struct Macro_table;
+
+/* The object files assemble writes, or-ed together in assembler_ctx.object_files */
+#define TEXT_OBJECT_FILES 1   /* The .ob, .ent and .ext files */
+#define BINARY_OBJECT_FILE 2  /* The .obb file (see object_file.h) */
+
+/*
+ * Struct: assembler_symbol
+ * ------------------------
+ * A symbol listed in the result of an assembly.
+ *
+ * Fields:
+ *  name    - The name of the label.
+ *  address - For an entry, the address of the label. For an external, the
+ *            address of the word referring to it.
+ */
+typedef struct assembler_symbol {
+  const char *name;
+  int address;
+} assembler_symbol;
+
+/*
+ * Struct: assembler_result
+ * ------------------------
+ * The output of a successful assembly, the in-memory equivalent of the .ob,
+ * .ent and .ext files. Everything is owned by the context's arena and stays
+ * valid until release_assembler_ctx.
+ *
+ * Fields:
+ *  words        - The code words followed by the data words. Word i is
+ *                 loaded at address START_ADDRESS + i; each holds 24 bits.
+ *  code_size    - The number of code words (ICF - START_ADDRESS).
+ *  data_size    - The number of data words (DCF).
+ *  entries      - The labels declared with .entry, in declaration order.
+ *  entry_count  - The number of entries.
+ *  externals    - The references to external labels, in code order.
+ *  extern_count - The number of external references.
+ *  relocations  - The addresses of the code words holding the address of a
+ *                 label of the file (marked R), in code order. A loader
+ *                 placing the code elsewhere adjusts exactly these words.
+ *  relocation_count - The number of relocations.
+ */
+typedef struct assembler_result {
+  unsigned long *words;
+  int code_size;
+  int data_size;
+  assembler_symbol *entries;
+  int entry_count;
+  assembler_symbol *externals;
+  int extern_count;
+  int *relocations;
+  int relocation_count;
+} assembler_result;
+
+/*
+ * Struct: assembler_ctx
+ * ---------------------
+ * The complete state of one assembly.
+ *
+ * Fields:
+ *  file_name       - The base name of the source file (without extension).
+ *  emit_am         - Whether the expanded source is also written to the .am file.
+ *  use_token_file  - Whether the lexed source is kept in the .amt file and
+ *                    loaded from it while the .as file is unchanged.
+ *  token_file      - The mapping of the loaded .amt file, or NULL.
+ *  token_file_size - The size of the mapping.
+ *  object_files    - The object files to write: TEXT_OBJECT_FILES, BINARY_OBJECT_FILE or both.
+ *  remove_stale    - Whether a .ent or .ext file left by an earlier run is removed
+ *                    when the source no longer has entries or externals.
+ *  arena           - The allocator owning every block allocated by the assembly.
+ *  messages        - Errors and warnings, when buffer_messages is set.
+ *  buffer_messages - 1 to collect messages in `messages`, 0 to print them directly.
+ *  on_failure      - Recovery point used when the arena runs out of memory.
+ *  macros          - The macro table built by the preprocessor.
+ *  expanded        - The source with all macros expanded.
+ *  symbols         - The interned identifiers of the source.
+ *  tokens          - The tokens of the expanded source, line by line.
+ *  label_table     - The symbol table.
+ *  entry_table     - The labels declared with .entry.
+ *  intern_table    - The label references to resolve in the second pass.
+ *  code_image      - The encoded instructions.
+ *  data_image      - The encoded data.
+ *  IC              - The final instruction counter (ICF) after the first pass.
+ *  DC              - The final data counter (DCF) after the first pass.
+ *  status          - NORMAL, or ERROR once an error has been found.
+ *  result          - The object words, entries and externals once assembled.
+ */
+typedef struct assembler_ctx {
+  const char *file_name;
+  int emit_am;
+  int use_token_file;
+  void *token_file;
+  size_t token_file_size;
+  int object_files;
+  int remove_stale;
+  Arena arena;
+  diagnostics messages;
+  int buffer_messages;
+  jmp_buf on_failure;
+  struct Macro_table *macros;
+  text_buffer expanded;
+  interner symbols;
+  token_stream tokens;
+  label_table_head *label_table;
+  entry_table_head *entry_table;
+  intern_table_head *intern_table;
+  memory code_image;
+  memory data_image;
+  int IC;
+  int DC;
+  enum errors status;
+  assembler_result result;
+} assembler_ctx;
+
+/*
+ * Function: init_assembler_ctx
+ * ----------------------------
+ * Prepares a context for assembling a source file. No memory is allocated
+ * until the context is assembled. The .amt file is not used unless
+ * use_token_file is set afterwards, only the textual object files are
+ * written unless object_files is changed, and stale .ent and .ext files are
+ * kept unless remove_stale is set.
+ *
+ * Parameters:
+ *  ctx             - The context to initialise.
+ *  file_name       - The base name of the source file (without extension).
+ *  emit_am         - Whether to also write the expanded source to the .am file.
+ *  buffer_messages - 1 to collect messages in ctx->messages, 0 to print them.
+ */
+void init_assembler_ctx(assembler_ctx *ctx, const char *file_name, int emit_am,
+                        int buffer_messages);
+
+/*
+ * Function: bind_assembler_ctx
+ * ----------------------------
+ * Makes the calling thread allocate from the context's arena and send its
+ * messages to the context. Binding NULL restores the defaults.
+ *
+ * Parameters:
+ *  ctx - The context to bind, or NULL.
+ */
+void bind_assembler_ctx(assembler_ctx *ctx);
+
+/*
+ * Function: assemble
+ * ------------------
+ * Preprocesses, assembles and writes the output files of the context's
+ * source file. The context is bound to the calling thread for the duration.
+ *
+ * Parameters:
+ *  ctx - The context to assemble.
+ *
+ * Returns:
+ *  NORMAL if the output files were written, ERROR otherwise.
+ */
+enum errors assemble(assembler_ctx *ctx);
+
+/*
+ * Function: assemble_source
+ * -------------------------
+ * Preprocesses and assembles source text held in memory. No file is read or
+ * written: the result is left in ctx->result, and errors are reported to
+ * ctx->messages when the context buffers its messages. The context's file
+ * name is only used to identify the source.
+ *
+ * Parameters:
+ *  ctx    - A context prepared with init_assembler_ctx.
+ *  source - The source text, in the format of a .as file.
+ *  length - The number of characters in source.
+ *
+ * Returns:
+ *  NORMAL if the source was assembled, ERROR otherwise.
+ */
+enum errors assemble_source(assembler_ctx *ctx, const char *source, size_t length);
+
+/*
+ * Function: release_assembler_ctx
+ * -------------------------------
+ * Releases all memory allocated during the assembly at once, and unmaps the
+ * .amt file if one was loaded. The collected
+ * messages are kept; release them with free_diagnostics once printed.
+ *
+ * Parameters:
+ *  ctx - The context to release.
+ */
+void release_assembler_ctx(assembler_ctx *ctx);
+
+#endif /* ASSEMBLER_H */
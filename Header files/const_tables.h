@@ -13,10 +13,50 @@
  *  - type: Represents the allowed addressing modes using bit fields.
  *  - operation_syntax: Holds full operation metadata for instruction parsing.
  *
+ * It also holds the character class table every scanner classifies bytes
+ * with, so that classifying a character is a single table load that does not
+ * depend on the locale.
+ *
+ * Constants:
+ *  - MIN_OPERATION_NAME_LEN: Length of the shortest mnemonic.
+ *  - MAX_OPERATION_NAME_LEN: Length of the longest mnemonic.
+ *  - CHAR_*: The character classes.
+ *
+ * Macros:
+ *  - CHAR_IS: Checks a character against a set of classes.
+ *
  * Function:
  *  - find_operation: Retrieves the operation syntax by name.
  */
 
+#include <stddef.h>
+
+#define MIN_OPERATION_NAME_LEN 3 /* Length of the shortest mnemonic ("mov") */
+#define MAX_OPERATION_NAME_LEN 4 /* Length of the longest mnemonic ("stop") */
+
+/* Character classes; a character may belong to several */
+#define CHAR_SPACE 0x01       /* Whitespace: ' ', '\t', '\n', '\v', '\f', '\r' */
+#define CHAR_LABEL_START 0x02 /* Can start a label: a letter or '_' */
+#define CHAR_LABEL 0x04       /* Can continue a label: a letter, a digit or '_' */
+#define CHAR_DIGIT 0x08       /* A decimal digit */
+#define CHAR_SIGN 0x10        /* '+' or '-' */
+#define CHAR_SEPARATOR 0x20   /* A single-character token: ',', ':', '#', '&' or '.' */
+#define CHAR_COMMENT 0x40     /* Starts a comment line: ';' */
+#define CHAR_LETTER 0x80      /* An ASCII letter */
+
+/*
+ * Macro: CHAR_IS
+ * Checks if a character belongs to any of a set of classes.
+ *
+ * Parameters:
+ *  c       - The character (any char value, including negative ones)
+ *  classes - The classes, or-ed together
+ *
+ * Returns:
+ *  Non-zero if the character is in one of the classes, 0 otherwise.
+ */
+#define CHAR_IS(c, classes) (char_classes[(unsigned char)(c)] & (classes))
+
 /*
  * Struct: type
  * Represents the allowed operand types for an operation's source or destination.
@@ -54,16 +94,33 @@ typedef struct operation {
   op_type destination_type;
 } operation_syntax;
 
+/*
+ * Constant: no_operation
+ * The syntax used for a name that is not an operation: no opcode and no
+ * allowed operands.
+ */
+extern const operation_syntax no_operation;
+
+/*
+ * Constant: char_classes
+ * The CHAR_* classes of each of the 256 byte values. Bytes outside ASCII
+ * belong to no class.
+ */
+extern const unsigned char char_classes[256];
+
 /*
  * Function: find_operation
- * Finds the operation syntax based on the given operation name.
+ * Finds the operation syntax based on the given operation name, using a
+ * perfect hash over the mnemonics. Does not report unknown names.
  *
  * Parameters:
- *  name - The operation mnemonic to search for
+ *  name   - The operation mnemonic to search for (need not be '\0'-terminated)
+ *  length - The number of characters in the mnemonic
  *
  * Returns:
- *  The matching operation_syntax structure with full metadata.
+ *  A pointer to the matching entry of the constant operation table, or NULL
+ *  if the name is not an operation.
  */
-operation_syntax find_operation(char *name);
+const operation_syntax *find_operation(const char *name, size_t length);
 
 #endif /* CONST_TABLES_H */
\ No newline at end of file
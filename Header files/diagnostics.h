@@ -0,0 +1,96 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stddef.h>
+
+/*
+ * File: diagnostics.h
+ * -------------------
+ * This header defines where the assembler's messages (errors, warnings and
+ * progress lines) are sent. By default they are printed to stdout as they
+ * are produced. A thread assembling a file in parallel with others binds a
+ * diagnostics buffer instead, so that the messages of each file can be
+ * printed together, in command-line order, once the file is done.
+ *
+ * Types:
+ *  - diagnostics: A growable buffer of messages.
+ *
+ * Functions:
+ *  - report: Formats a message into the bound buffer, or prints it.
+ *  - bind_diagnostics: Sends the calling thread's messages to a buffer.
+ *  - flush_diagnostics: Prints a buffer to stdout and empties it.
+ *  - free_diagnostics: Releases the memory held by a buffer.
+ */
+
+/*
+ * Constant: DIAGNOSTIC_LINE_SIZE
+ * ------------------------------
+ * Room reserved in a buffer before formatting each message. Longer messages
+ * are formatted a second time once the buffer has grown to fit them.
+ */
+#define DIAGNOSTIC_LINE_SIZE 256
+
+/*
+ * Struct: diagnostics
+ * -------------------
+ * The messages produced while assembling one file. The buffer is managed with
+ * malloc rather than the arena, so it outlives the arena of the file it
+ * belongs to. A zero-initialised diagnostics is a valid empty buffer.
+ *
+ * Fields:
+ *  text     - The formatted messages.
+ *  length   - The number of characters in use.
+ *  capacity - The number of characters allocated.
+ */
+typedef struct {
+  char *text;
+  size_t length;
+  size_t capacity;
+} diagnostics;
+
+/*
+ * Function: report
+ * ----------------
+ * Formats a message like printf. The message is appended to the buffer bound
+ * to the calling thread, or printed to stdout if no buffer is bound.
+ *
+ * Parameters:
+ *  format - A printf format string, followed by its arguments.
+ *
+ * Returns:
+ *  The number of characters in the message.
+ */
+int report(const char *format, ...);
+
+/*
+ * Function: bind_diagnostics
+ * --------------------------
+ * Sends the messages of the calling thread to a buffer. Binding NULL sends
+ * them to stdout again.
+ *
+ * Parameters:
+ *  buffer - The buffer to collect messages in, or NULL.
+ */
+void bind_diagnostics(diagnostics *buffer);
+
+/*
+ * Function: flush_diagnostics
+ * ---------------------------
+ * Prints the collected messages to stdout and empties the buffer.
+ *
+ * Parameters:
+ *  buffer - The buffer to print.
+ */
+void flush_diagnostics(diagnostics *buffer);
+
+/*
+ * Function: free_diagnostics
+ * --------------------------
+ * Releases the memory held by a buffer, leaving it empty.
+ *
+ * Parameters:
+ *  buffer - The buffer to release.
+ */
+void free_diagnostics(diagnostics *buffer);
+
+#endif /* DIAGNOSTICS_H */
@@ -14,6 +14,7 @@
  *  - Final object code
  *  - External references
  *  - Entry point labels
+ *  - Output files that are still being written
  */
 
 /*
@@ -22,6 +23,7 @@
  */
 #define PREPROCESSOR_INPUT_EXT ".as"  /* Original source file */
 #define PREPROCESSOR_OUTPUT_EXT ".am" /* After macro processing */
+#define TOKEN_FILE_EXT ".amt"         /* After macro processing, lexed (binary) */
 
 /*
  * Assembler output file extensions
@@ -29,5 +31,7 @@
 #define OBJECT_FILE_EXT ".ob"    /* Final assembled machine code */
 #define EXTERNALS_FILE_EXT ".ext" /* External labels used by this file */
 #define ENTRIES_FILE_EXT ".ent"  /* Entry labels defined in this file */
+#define BINARY_OBJECT_FILE_EXT ".obb" /* The .ob, .ent and .ext contents, binary */
+#define TEMP_FILE_EXT ".tmp"     /* Ends the temporary name of an output file being written */
 
 #endif /* FILE_EXTENSIONS_H */
\ No newline at end of file
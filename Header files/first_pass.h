@@ -4,13 +4,15 @@
 #include <mem_image.h>
 #include <preprocessor.h>
 #include <tables.h>
+#include <input.h>
+#include <assembler.h>
 
 /**
  * File: first_pass.h
  * ------------------
  * Purpose:
  *   Declares the interface for the first pass of a two-pass assembler.
- *   The first pass processes a preprocessed assembly file (.am), identifies
+ *   The first pass processes the preprocessed (macro expanded) source, identifies
  *   and validates labels and instructions, builds the symbol table, and
  *   prepares memory images (IC and DC) for the second pass.
  *
@@ -30,9 +32,6 @@
  *   - Standard C libraries  : For string manipulation and character checks
  */
 
-/* Define the input file extension for the assembler (.am) */
-#define ASSEMBLER_INPUT_EXT PREPROCESSOR_OUTPUT_EXT
-
 /* Constants for syntax recognition and validation */
 #define MAX_OPERATION_LEN 3             /* Maximum number of words for an operation */
 #define IMMEDIATE_PARAM_INDICATOR '#'   /* Prefix for immediate values */
@@ -41,19 +40,6 @@
 #define RELATIVE_INDICATOR '&'          /* Prefix for relative address operands */
 #define OPERAND_SEPARATOR ','           /* Character used to separate operands */
 
-/**
- * Macro: IGNORE_WHITESPACE
- * -------------------------
- * Advances a pointer past leading whitespace characters.
- *
- * Parameters:
- *   work_line - A pointer to a character array (string)
- */
-#define IGNORE_WHITESPACE(work_line)                                           \
-  while (isspace(*work_line)) {                                                \
-    work_line++;                                                               \
-  }
-
 /**
  * Enum: op_type
  * -------------
@@ -64,42 +50,49 @@
 enum op_type { DEST, SOURCE };
 
 /**
- * Function: check_label_conflicts
- * -------------------------------
- * Checks whether a given label name conflicts with existing labels
- * or reserved keywords, and updates the error status if necessary.
+ * Function: define_label
+ * ----------------------
+ * Defines a label in the symbol table with a single find-or-insert probe.
+ * If the name is already taken, a conflict is reported, the error status
+ * is updated and the existing label is left unchanged.
  *
  * Parameters:
  *   status      - Pointer to the current error status enum
  *   label_table - Pointer to the symbol table of labels
- *   label_name  - The label name to check
+ *   label       - The interned name of the label to define
+ *   value       - The address (IC or DC) of the label
+ *   type        - The type of the label (DATA or CODE)
  *   line_number - The line number of the current input line (for error reporting)
  */
-void check_label_conflicts(enum errors *status, label_table_head *label_table,
-                           char *label_name, const int line_number);
+void define_label(enum errors *status, label_table_head *label_table,
+                  unsigned int label, int value, label_data_type type,
+                  const int line_number);
 
 /**
  * Function: write_str
  * -------------------
- * Writes a string (null-terminated) to the data image, starting at DC.
- * Each character is stored as an individual word.
+ * Writes a string to the data image, starting at DC, followed by a
+ * terminating zero word. Each character is stored as an individual word.
  *
  * Parameters:
- *   data_image - The memory array representing the data image
+ *   data_image - The memory image for data (grows as needed)
  *   DC         - The current data counter
- *   str        - The string to write into memory
+ *   str        - The characters to write into memory
+ *   length     - The number of characters
  */
-void write_str(memory data_image, int DC, char *str);
+void write_str(memory *data_image, int DC, const char *str, size_t length);
 
 /**
  * Function: extract_operand
  * -------------------------
- * Parses and encodes an operand from a string into memory words.
+ * Parses and encodes an operand from a range of tokens into memory words.
  *
  * Parameters:
- *   operand        - The raw operand string
+ *   line           - The tokens of the line holding the operand
+ *   first          - The index of the first token of the operand
+ *   end            - The index of the first token after the operand
  *   temp           - Temporary memory words to hold the operand encoding
- *   operand_label  - Output: pointer to extracted label (if applicable)
+ *   operand_label  - Output: the interned label of the operand, or NO_SYMBOL
  *   operand_number - Position of the operand (1st or 2nd)
  *   type           - Operand type (SOURCE or DEST)
  *   relative       - Output: flag indicating if the operand is relative
@@ -107,8 +100,8 @@ void write_str(memory data_image, int DC, char *str);
  * Returns:
  *   The number of words used to encode the operand (0 if error)
  */
-int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN],
-                    char **operand_label, int operand_number, enum op_type type,
+int extract_operand(token_cursor *line, int first, int end, memory_word temp[MAX_OPERATION_LEN],
+                    unsigned int *operand_label, int operand_number, enum op_type type,
                     int *relative);
 
 /**
@@ -120,29 +113,32 @@ int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN],
  * Parameters:
  *   errors       - Pointer to the current error status
  *   macro_table  - Pointer to the macro table structure
- *   intern_name  - Name of the label being validated
+ *   label        - Interned name of the label being validated
  *   line_number  - The line number for reporting
  */
-void check_macro_conflicts(enum errors * errors, struct Macro_table * macro_table, char * intern_name,
+void check_macro_conflicts(enum errors * errors, struct Macro_table * macro_table, unsigned int label,
                            int line_number);
 
 /**
  * Function: first_pass
  * --------------------
- * Executes the first pass of the assembler on the specified input file.
- * This function opens the .am file, reads it line by line, validates syntax,
- * builds the symbol table, handles macros, and constructs memory images.
+ * Executes the first pass of the assembler on the expanded source.
+ * This function reads the source the preprocessor stored in the context
+ * line by line, validates syntax, builds the symbol table, handles macros,
+ * and constructs memory images.
  *
  * Parameters:
- *   file_name   - The base name of the source file (without extension)
- *   macro_table - A pointer to the macro table, used for validating macro usage
+ *   ctx - The assembler context of the file, after preprocess
  *
  * Output:
- *   - Populates symbol table
- *   - Fills data image
- *   - Tracks IC/DC
+ *   - Stores the symbol, entry and intern tables in the context
+ *   - Fills the code and data images of the context
+ *   - Stores the final IC/DC in the context
  *   - Reports errors to the user
+ *
+ * Returns:
+ *   NORMAL if the source has no errors, ERROR otherwise
  */
-void first_pass(const char *file_name, Macro_table *macro_table);
+enum errors first_pass(assembler_ctx *ctx);
 
-#endif /* FIRST_PASS_H */
\ No newline at end of file
+#endif /* FIRST_PASS_H */
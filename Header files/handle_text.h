@@ -1,7 +1,6 @@
 #ifndef HANDLE_TEXT_H
 #define HANDLE_TEXT_H
 
-#include <ctype.h>  /* For character classification functions like isdigit() */
 #include <mem_image.h>
 #include <tables.h>
 #include <parsing.h>
@@ -36,16 +35,16 @@
  * in the data image.
  *
  * Parameters:
- *   line        - The line containing the numeric data
+ *   line        - The tokens of the line, positioned after the directive
  *   line_number - Line number (for error reporting)
  *   status      - Pointer to the error status
- *   data_image  - Memory array for storing data values
+ *   data_image  - Memory image for storing data values (grows as needed)
  *   DC          - Current value of the Data Counter
  *
  * Returns:
  *   Number of data words successfully written, or 0 if an error occurred
  */
-int handle_numbers(char *line, int line_number, enum errors *status, memory data_image, int DC);
+int handle_numbers(token_cursor *line, int line_number, enum errors *status, memory *data_image, int DC);
 
 /*
  * Function: handle_data_instruction
@@ -55,14 +54,14 @@ int handle_numbers(char *line, int line_number, enum errors *status, memory data
  *
  * Parameters:
  *   DC              - Pointer to the data counter
- *   data_image      - Memory array representing the data segment
+ *   data_image      - Memory image representing the data segment
  *   status          - Pointer to the error status
- *   work_line       - Line of source code to process
+ *   line            - The tokens of the line, positioned after the directive
  *   instruction_type - Either DATA or STRING directive type
  *   line_number     - Line number (for error reporting)
  */
-void handle_data_instruction(int *DC, memory data_image, enum errors *status,
-                             char *work_line, inst instruction_type, int line_number);
+void handle_data_instruction(int *DC, memory *data_image, enum errors *status,
+                             token_cursor *line, inst instruction_type, int line_number);
 
 /*
  * Function: handle_instruction
@@ -76,14 +75,14 @@ void handle_data_instruction(int *DC, memory data_image, enum errors *status,
  *   status         - Pointer to the current error status
  *   label_table    - Pointer to the label symbol table
  *   entry_table    - Pointer to the .entry label table
- *   work_line      - Line of code to parse
- *   label_name     - Output: Pointer to label name, if defined
+ *   line           - The tokens of the line, positioned after the directive
+ *   label          - Output: the interned label name, if defined
  *   instruction_type - The directive type to handle (.data, .string, etc.)
  *   line_number    - Current line number in the file
  *   label_flag     - Indicates if a label was declared on this line
  */
 void handle_instruction(int *DC, memory *data_image, enum errors *status, label_table_head *label_table,
-                        entry_table_head *entry_table, char *work_line, char **label_name, inst instruction_type,
+                        entry_table_head *entry_table, token_cursor *line, unsigned int *label, inst instruction_type,
                         int line_number, int label_flag);
 
 /*
@@ -93,36 +92,39 @@ void handle_instruction(int *DC, memory *data_image, enum errors *status, label_
  *
  * Parameters:
  *   temp         - Temporary memory word array to hold encoded instruction
- *   source_label - Output: pointer to source label (NULL for this type)
- *   dest_label   - Output: pointer to destination label (NULL for this type)
- *   line         - The line to process
+ *   source_label - Output: source label (NO_SYMBOL for this type)
+ *   dest_label   - Output: destination label (NO_SYMBOL for this type)
+ *   line         - The tokens of the line, positioned after the operation name
  *   syntax       - Expected syntax structure for the operation
  *   value1       - Output: Value to write into instruction word (if any)
  *
  * Returns:
  *   1 if successfully parsed, 0 if syntax error occurred
  */
-int handle_no_operand_operation(memory_word *temp, char **source_label, char **dest_label,
-                                char *line, operation_syntax syntax, int *value1);
+int handle_no_operand_operation(memory_word *temp, unsigned int *source_label, unsigned int *dest_label,
+                                const token_cursor *line, operation_syntax syntax, int *value1);
 
 /*
  * Function: handle_operation
  * --------------------------
  * Parses a line containing an instruction (with or without operands),
- * validates operands, and encodes instruction into the code image.
+ * validates operands, and encodes instruction into the code image. Label
+ * operands whose address is known are patched at once; the others are
+ * recorded for backpatching.
  *
  * Parameters:
- *   work_line   - Pointer to the current line being parsed
+ *   line        - The tokens of the line, positioned at the operation
  *   status      - Pointer to the error status
- *   table       - Pointer to intern label table (for references)
+ *   label_table - Pointer to the label table (for resolving references)
+ *   table       - Pointer to intern label table (for pending references)
  *   line_number - Line number of the instruction in the source file
- *   code_image  - Memory array for storing encoded instruction words
+ *   code_image  - Memory image for storing encoded instruction words (grows as needed)
  *   IC          - Instruction counter for current location in memory
  *
  * Returns:
  *   Number of words written to the code image (0 if error)
  */
-int handle_operation(char **work_line, enum errors *status, intern_table_head *table, int line_number,
-                     memory code_image, const int IC);
+int handle_operation(token_cursor *line, enum errors *status, label_table_head *label_table,
+                     intern_table_head *table, int line_number, memory *code_image, const int IC);
 
 #endif /* HANDLE_TEXT_H */
\ No newline at end of file
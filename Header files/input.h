@@ -10,36 +10,157 @@
  * This header defines utility functions for handling file input,
  * especially for reading source lines and handling file name extensions.
  *
+ * Types:
+ *  - line_reader: Hands out the lines of a file without copying them.
+ *  - text_buffer: A growable in-memory text, e.g. the expanded source.
+ *
  * Functions:
- *  - getLine: Dynamically reads a full line of any length from a file.
+ *  - open_line_reader: Maps (or reads) a whole file for line-by-line access.
+ *  - open_buffer_reader: Reads the lines of an in-memory text buffer.
+ *  - next_line: Returns a view of the next line of the file.
+ *  - close_line_reader: Releases the file contents of a reader.
+ *  - init_text_buffer: Creates an empty text buffer.
+ *  - append_text: Appends characters to a text buffer.
  *  - add_extension: Appends a file extension to a base filename.
  *
  * Constants:
- *  - STARTING_LINE_SIZE: Initial allocation size for reading lines.
+ *  - READ_CHUNK_SIZE: Size of each read when a file cannot be mapped.
+ */
+
+/*
+ * Constant: READ_CHUNK_SIZE
+ * -------------------------
+ * The number of bytes requested per read() call when the input is not a
+ * regular file (e.g. a pipe) and therefore cannot be memory mapped.
+ */
+#define READ_CHUNK_SIZE (64 * 1024)
+
+/*
+ * Enum: reader_source
+ * -------------------
+ * Where the contents of a line_reader come from, which decides how the
+ * reader releases them.
+ *
+ * Values:
+ *  READER_MAPPED   - A private memory mapping of the file.
+ *  READER_BUFFERED - A buffer the reader read the file into.
+ *  READER_BORROWED - A text buffer owned by the caller.
+ */
+typedef enum { READER_MAPPED, READER_BUFFERED, READER_BORROWED } reader_source;
+
+/*
+ * Struct: line_reader
+ * -------------------
+ * Holds the complete contents of an input and the position of the
+ * next unread line. Regular files are memory mapped privately; anything
+ * else is read into one large buffer. Each line is handed out in place:
+ * its terminating newline is overwritten with '\0', so a line view is both
+ * a (pointer, length) pair and a C string, and no line is ever copied.
+ *
+ * Fields:
+ *  data     - The file contents.
+ *  size     - The number of bytes of file contents.
+ *  position - Offset of the first byte of the next line.
+ *  source   - Where data comes from (mapping, read buffer or borrowed text).
+ */
+typedef struct {
+  char *data;
+  size_t size;
+  size_t position;
+  reader_source source;
+} line_reader;
+
+/*
+ * Struct: text_buffer
+ * -------------------
+ * A growable, '\0'-terminated run of text. The preprocessor expands the
+ * source into one of these, and the first pass reads its lines from it.
+ *
+ * Fields:
+ *  text     - The characters, always followed by a '\0'.
+ *  length   - The number of characters in use.
+ *  capacity - The number of characters that fit before the buffer grows.
+ */
+typedef struct {
+  char *text;
+  size_t length;
+  size_t capacity;
+} text_buffer;
+
+/*
+ * Function: open_line_reader
+ * --------------------------
+ * Opens a file and makes its whole contents available to next_line.
+ *
+ * Parameters:
+ *  reader    - The reader to initialise.
+ *  file_name - The path of the file to open.
+ *
+ * Returns:
+ *  1 on success, 0 if the file could not be opened or read.
  */
+int open_line_reader(line_reader *reader, const char *file_name);
 
 /*
- * Constant: STARTING_LINE_SIZE
+ * Function: open_buffer_reader
  * ----------------------------
- * The initial buffer size allocated for reading a line from file.
- * The buffer is expanded dynamically if the line exceeds this size.
+ * Makes the lines of a text buffer available to next_line. The lines are
+ * terminated in place, so the buffer must not be used as a whole afterwards.
+ *
+ * Parameters:
+ *  reader - The reader to initialise.
+ *  buffer - The text buffer to read; it stays owned by the caller.
  */
-#define STARTING_LINE_SIZE 64
+void open_buffer_reader(line_reader *reader, text_buffer *buffer);
 
 /*
- * Function: getLine
- * -----------------
- * Reads a single line of arbitrary length from the input file.
- * The returned pointer is dynamically allocated and must be freed
- * by the caller.
+ * Function: next_line
+ * -------------------
+ * Returns the next line of the file. The view stays valid until the
+ * reader is closed and must not be freed by the caller.
  *
  * Parameters:
- *  input - A pointer to the file to read from.
+ *  reader - The reader to take the line from.
+ *  length - Output: the length of the line, excluding the newline (may be NULL).
  *
  * Returns:
- *  A dynamically allocated string containing the full line, or NULL on failure.
+ *  A pointer to the '\0'-terminated line, or NULL at end of file.
+ */
+char *next_line(line_reader *reader, size_t *length);
+
+/*
+ * Function: close_line_reader
+ * ---------------------------
+ * Releases the file contents of a reader. All line views handed out by
+ * the reader become invalid.
+ *
+ * Parameters:
+ *  reader - The reader to close.
+ */
+void close_line_reader(line_reader *reader);
+
+/*
+ * Function: init_text_buffer
+ * --------------------------
+ * Initialises an empty text buffer with room for a number of characters.
+ *
+ * Parameters:
+ *  buffer   - The buffer to initialise.
+ *  capacity - The number of characters to reserve.
+ */
+void init_text_buffer(text_buffer *buffer, size_t capacity);
+
+/*
+ * Function: append_text
+ * ---------------------
+ * Appends characters to a text buffer, doubling its capacity as needed.
+ *
+ * Parameters:
+ *  buffer - The buffer to append to.
+ *  text   - The characters to append.
+ *  length - The number of characters to append.
  */
-char *getLine(FILE *input);
+void append_text(text_buffer *buffer, const char *text, size_t length);
 
 /*
  * Function: add_extension
@@ -57,4 +178,4 @@ char *getLine(FILE *input);
  */
 char *add_extension(const char *filename, const char *extension);
 
-#endif /* INPUT_H */
\ No newline at end of file
+#endif /* INPUT_H */
@@ -0,0 +1,170 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+/*
+ * File: interner.h
+ * ----------------
+ * This header defines the string interner of an assembly. Every distinct
+ * identifier of the source is stored once and named by a small integer id,
+ * so that later stages compare and index symbols by id instead of by string.
+ *
+ * The strings themselves are packed one after the other into large pool
+ * blocks, so interning a new string is a copy into the current block rather
+ * than an allocation of its own.
+ *
+ * Constants:
+ *  - NO_SYMBOL             : The id of no symbol.
+ *  - INTERNER_MIN_CAPACITY : The smallest number of symbols an interner holds.
+ *  - INTERNER_POOL_SIZE    : The number of characters in each pool block.
+ *
+ * Types:
+ *  - symbol   : An interned string.
+ *  - interner : The set of interned strings of an assembly.
+ *
+ * Functions:
+ *  - hash_text      : Hashes a string that need not be '\0'-terminated.
+ *  - init_interner  : Prepares an empty interner.
+ *  - intern         : Returns the id of a string, interning it if it is new.
+ *  - find_symbol    : Returns the id of a string if it is interned.
+ *  - restore_symbol : Adds a string that is kept outside the interner.
+ *  - symbol_name    : Returns the interned string of an id.
+ */
+
+#include <stddef.h>
+
+#define NO_SYMBOL ((unsigned int)-1)  /* Id of no symbol */
+#define INTERNER_MIN_CAPACITY 64      /* Smallest symbol capacity, a power of two */
+#define INTERNER_POOL_SIZE 4096       /* Characters per block of interned strings */
+
+/*
+ * Struct: symbol
+ * --------------
+ * An interned string.
+ *
+ * Fields:
+ *  name   - The string, '\0'-terminated and owned by the interner.
+ *  length - The number of characters in the string.
+ *  hash   - The hash of the string.
+ */
+typedef struct {
+  const char *name;
+  size_t length;
+  unsigned long hash;
+} symbol;
+
+/*
+ * Struct: interner
+ * ----------------
+ * The interned strings of an assembly, numbered from 0 in the order they
+ * were first seen, and an open-addressing hash index (linear probing) over
+ * them.
+ *
+ * Fields:
+ *  symbols   - The interned strings, indexed by id.
+ *  count     - The number of interned strings.
+ *  capacity  - The number of slots, and of symbols that fit; a power of two.
+ *  slots     - The hash index: id + 1 of the symbol in each slot, 0 when empty.
+ *  pool      - The free part of the current block of interned strings.
+ *  pool_free - The number of characters left in the current block.
+ */
+typedef struct {
+  symbol *symbols;
+  unsigned int count;
+  unsigned int capacity;
+  unsigned int *slots;
+  char *pool;
+  size_t pool_free;
+} interner;
+
+/*
+ * Function: hash_text
+ * -------------------
+ * Computes the FNV-1a hash of a string given as a slice.
+ *
+ * Parameters:
+ *  text   - The first character of the string.
+ *  length - The number of characters in the string.
+ *
+ * Returns:
+ *  The 32-bit hash of the string.
+ */
+unsigned long hash_text(const char *text, size_t length);
+
+/*
+ * Function: init_interner
+ * -----------------------
+ * Prepares an empty interner with room for a number of symbols.
+ *
+ * Parameters:
+ *  symbols          - The interner to initialise.
+ *  expected_symbols - The number of symbols expected.
+ */
+void init_interner(interner *symbols, size_t expected_symbols);
+
+/*
+ * Function: intern
+ * ----------------
+ * Returns the id of a string, copying it into the interner the first time
+ * it is seen. The string is a borrowed slice, so it can point straight into
+ * a source line.
+ *
+ * Parameters:
+ *  symbols - The interner.
+ *  text    - The first character of the string.
+ *  length  - The number of characters in the string.
+ *
+ * Returns:
+ *  The id of the string.
+ */
+unsigned int intern(interner *symbols, const char *text, size_t length);
+
+/*
+ * Function: find_symbol
+ * ---------------------
+ * Looks a string up without interning it.
+ *
+ * Parameters:
+ *  symbols - The interner.
+ *  text    - The first character of the string.
+ *  length  - The number of characters in the string.
+ *
+ * Returns:
+ *  The id of the string, or NO_SYMBOL if it has not been interned.
+ */
+unsigned int find_symbol(const interner *symbols, const char *text, size_t length);
+
+/*
+ * Function: restore_symbol
+ * ------------------------
+ * Gives the next id to a string without copying it, for rebuilding an
+ * interner from a .amt file: restoring the strings in id order gives them
+ * their original ids, and their stored hashes spare hashing them again.
+ *
+ * Parameters:
+ *  symbols - The interner.
+ *  name    - The '\0'-terminated string; it must not be interned yet and
+ *            must stay valid for as long as the interner.
+ *  length  - The number of characters in the string.
+ *  hash    - The hash of the string, as computed by hash_text.
+ *
+ * Returns:
+ *  The id of the string.
+ */
+unsigned int restore_symbol(interner *symbols, const char *name, size_t length,
+                            unsigned long hash);
+
+/*
+ * Function: symbol_name
+ * ---------------------
+ * Returns the interned string of an id.
+ *
+ * Parameters:
+ *  symbols - The interner.
+ *  id      - An id returned by intern.
+ *
+ * Returns:
+ *  The '\0'-terminated string, valid for as long as the interner.
+ */
+const char *symbol_name(const interner *symbols, unsigned int id);
+
+#endif /* INTERNER_H */
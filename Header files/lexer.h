@@ -0,0 +1,265 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+/*
+ * File: lexer.h
+ * -------------
+ * This header defines the tokens of the assembly language and the token
+ * stream shared by the assembler's phases. Each line of the source is
+ * tokenized exactly once, by the preprocessor; macro bodies keep their
+ * tokens and are expanded by copying them, and the first pass and the
+ * operand parsers read the expanded source through its tokens instead of
+ * scanning the characters again.
+ *
+ * A token is a slice of its line (an offset and a length) with its kind and,
+ * for identifiers, the interned id of its text, so no token is ever copied
+ * out of the source to be examined.
+ *
+ * Constants:
+ *  - SOURCE_BYTES_PER_LINE : Estimated source bytes per line, for presizing.
+ *  - TOKENS_PER_LINE       : Estimated tokens per source line, for presizing.
+ *
+ * Types:
+ *  - token_kind   : The kinds of tokens.
+ *  - token        : A token of a line.
+ *  - token_line   : The tokens of one line of the source.
+ *  - token_stream : The tokens of a whole source, line by line.
+ *  - token_cursor : A position in the tokens of one line, for the parsers.
+ *
+ * Functions:
+ *  - init_token_stream  : Prepares an empty token stream.
+ *  - lex_line           : Tokenizes a line onto the end of a stream.
+ *  - add_token_line     : Records a line made of the last tokens of a stream.
+ *  - append_token_lines : Appends the lines of one stream to another.
+ *  - open_token_cursor  : Positions a cursor at the first token of a line.
+ *  - peek_token         : Returns the next token of a cursor.
+ *  - run_end            : Finds the end of a run of tokens not separated by whitespace.
+ *  - token_equals       : Compares the text of a token with a word.
+ */
+
+#include <stddef.h>
+#include "interner.h"
+
+#define SOURCE_BYTES_PER_LINE 16  /* Rough number of source bytes on a line */
+#define TOKENS_PER_LINE 4         /* Rough number of tokens on a line of source */
+
+/*
+ * Enum: token_kind
+ * ----------------
+ *  TOKEN_IDENTIFIER - A letter or '_' followed by letters, digits and '_'.
+ *  TOKEN_NUMBER     - Decimal digits, with a '+' or '-' sign glued to them.
+ *  TOKEN_STRING     - After a .string instruction, a '"' up to the next '"',
+ *                     or to the end of the line if it is not closed.
+ *  TOKEN_COMMENT    - A whole line starting with ';'.
+ *  TOKEN_COMMA      - ','
+ *  TOKEN_COLON      - ':'
+ *  TOKEN_HASH       - '#'
+ *  TOKEN_AMPERSAND  - '&'
+ *  TOKEN_DOT        - '.'
+ *  TOKEN_OTHER      - Any other single character.
+ */
+typedef enum {
+  TOKEN_IDENTIFIER,
+  TOKEN_NUMBER,
+  TOKEN_STRING,
+  TOKEN_COMMENT,
+  TOKEN_COMMA,
+  TOKEN_COLON,
+  TOKEN_HASH,
+  TOKEN_AMPERSAND,
+  TOKEN_DOT,
+  TOKEN_OTHER
+} token_kind;
+
+/*
+ * Struct: token
+ * -------------
+ * A token, as a slice of its line.
+ *
+ * Fields:
+ *  kind   - The token_kind of the token.
+ *  offset - The offset of the first character from the start of the line.
+ *  length - The number of characters in the token.
+ *  symbol - The interned id of an identifier's text, NO_SYMBOL otherwise.
+ */
+typedef struct {
+  unsigned char kind;
+  unsigned int offset;
+  unsigned int length;
+  unsigned int symbol;
+} token;
+
+/*
+ * Struct: token_line
+ * ------------------
+ * The tokens of one line.
+ *
+ * Fields:
+ *  text_offset - The offset of the line in the source text.
+ *  first_token - The index of the first token of the line in the stream.
+ *  token_count - The number of tokens on the line (0 for a blank line).
+ */
+typedef struct {
+  size_t text_offset;
+  int first_token;
+  int token_count;
+} token_line;
+
+/*
+ * Struct: token_stream
+ * --------------------
+ * The tokens of a source text and the lines they belong to, each in one
+ * growable array.
+ *
+ * Fields:
+ *  tokens         - The tokens, line after line.
+ *  token_count    - The number of tokens.
+ *  token_capacity - The number of tokens that fit before the array grows.
+ *  lines          - The lines, in source order.
+ *  line_count     - The number of lines.
+ *  line_capacity  - The number of lines that fit before the array grows.
+ */
+typedef struct {
+  token *tokens;
+  int token_count;
+  int token_capacity;
+  token_line *lines;
+  int line_count;
+  int line_capacity;
+} token_stream;
+
+/*
+ * Struct: token_cursor
+ * --------------------
+ * The parsers' view of one line: its text, its tokens and the next token to
+ * be consumed.
+ *
+ * Fields:
+ *  text     - The line; token offsets are relative to it.
+ *  tokens   - The tokens of the line.
+ *  count    - The number of tokens.
+ *  position - The index of the next token to consume.
+ *  symbols  - The interner holding the identifiers of the tokens.
+ */
+typedef struct {
+  const char *text;
+  const token *tokens;
+  int count;
+  int position;
+  interner *symbols;
+} token_cursor;
+
+/*
+ * Function: init_token_stream
+ * ---------------------------
+ * Prepares an empty token stream with room for a number of tokens and lines.
+ *
+ * Parameters:
+ *  stream          - The stream to initialise.
+ *  expected_tokens - The number of tokens to reserve.
+ *  expected_lines  - The number of lines to reserve.
+ */
+void init_token_stream(token_stream *stream, size_t expected_tokens, size_t expected_lines);
+
+/*
+ * Function: lex_line
+ * ------------------
+ * Tokenizes a line and appends its tokens to a stream, interning the text of
+ * every identifier. The line is not recorded; see add_token_line.
+ *
+ * Parameters:
+ *  stream  - The stream to append the tokens to.
+ *  symbols - The interner for the identifiers.
+ *  line    - The line, without its newline.
+ *  length  - The number of characters in the line.
+ *
+ * Returns:
+ *  The number of tokens appended.
+ */
+int lex_line(token_stream *stream, interner *symbols, const char *line, size_t length);
+
+/*
+ * Function: add_token_line
+ * ------------------------
+ * Records a line whose tokens are the last token_count tokens of the stream.
+ *
+ * Parameters:
+ *  stream      - The stream.
+ *  text_offset - The offset of the line in the source text.
+ *  token_count - The number of tokens on the line.
+ */
+void add_token_line(token_stream *stream, size_t text_offset, int token_count);
+
+/*
+ * Function: append_token_lines
+ * ----------------------------
+ * Appends all the lines of a stream, with their tokens, to another stream,
+ * as if their text had been appended at the given offset.
+ *
+ * Parameters:
+ *  stream      - The stream to append to.
+ *  lines       - The stream whose lines are appended.
+ *  text_offset - The offset in the source of the text of the first line.
+ */
+void append_token_lines(token_stream *stream, const token_stream *lines, size_t text_offset);
+
+/*
+ * Function: open_token_cursor
+ * ---------------------------
+ * Positions a cursor at the first token of a line of a stream.
+ *
+ * Parameters:
+ *  cursor  - The cursor to position.
+ *  stream  - The stream.
+ *  line    - The index of the line.
+ *  text    - The source text of the stream.
+ *  symbols - The interner of the stream.
+ */
+void open_token_cursor(token_cursor *cursor, const token_stream *stream, int line,
+                       const char *text, interner *symbols);
+
+/*
+ * Function: peek_token
+ * --------------------
+ * Returns the next token of a cursor without consuming it.
+ *
+ * Parameters:
+ *  cursor - The cursor.
+ *
+ * Returns:
+ *  The next token, or NULL at the end of the line.
+ */
+const token *peek_token(const token_cursor *cursor);
+
+/*
+ * Function: run_end
+ * -----------------
+ * Finds where a run of tokens that are not separated by whitespace ends,
+ * that is where a word of the line would end if it was read up to the
+ * first whitespace.
+ *
+ * Parameters:
+ *  cursor - The cursor of the line.
+ *  first  - The index of the first token of the run.
+ *
+ * Returns:
+ *  The index of the first token after the run.
+ */
+int run_end(const token_cursor *cursor, int first);
+
+/*
+ * Function: token_equals
+ * ----------------------
+ * Checks if the text of a token is exactly a given word.
+ *
+ * Parameters:
+ *  cursor - The cursor of the line holding the token.
+ *  tok    - The token.
+ *  word   - The '\0'-terminated word.
+ *
+ * Returns:
+ *  1 if the token is the word, 0 otherwise.
+ */
+int token_equals(const token_cursor *cursor, const token *tok, const char *word);
+
+#endif /* LEXER_H */
@@ -10,18 +10,32 @@
  * It includes structures and types for encoding instructions, operands,
  * characters, and data values, all packed into a uniform 24-bit memory word.
  *
+ * The code and data images grow on demand in page-sized chunks, so there is
+ * no upper limit on the size of a program and small programs only pay for
+ * the chunks they use.
+ *
  * Constants:
- *  - START_ADDRESS: Starting address of the memory in the assembler (usually 100).
- *  - MAX_MEM_SIZE : Maximum number of memory words (1024 entries).
+ *  - START_ADDRESS        : Starting address of the memory in the assembler (usually 100).
+ *  - MEMORY_CHUNK_WORDS   : Number of memory words in each chunk of an image.
+ *  - SOURCE_BYTES_PER_WORD: Estimated source bytes per memory word, for presizing.
  *
  * Types:
  *  - operand_type : Enum for addressing methods.
  *  - memory_word  : Union of all memory cell types.
- *  - memory       : The actual simulated memory array.
+ *  - memory       : A growable image of memory words.
+ *
+ * Functions:
+ *  - init_memory_image: Prepares an empty image presized for a source.
+ *  - image_word       : Returns a word of an image, growing the image as needed.
  */
 
+#include <stddef.h>
+
 #define START_ADDRESS 100        /* Initial memory address for code section */
-#define MAX_MEM_SIZE 1<<10       /* Maximum memory size (1024 words) */
+#define MEMORY_CHUNK_WORDS 1024  /* Words per chunk (one 4KB page of 32-bit words) */
+#define SOURCE_BYTES_PER_WORD 8  /* Rough number of source bytes per encoded word */
+#define DATA_MAX 8388607L        /* Largest .data value: 2^23 - 1 */
+#define DATA_MIN (-8388608L)     /* Smallest .data value: -2^23 */
 
 /*
  * Enum: operand_type
@@ -125,9 +139,47 @@ typedef union {
 /*
  * Type: memory
  * ------------
- * Represents the full memory space for the assembler.
- * This array holds all encoded instructions, operands, and data words.
+ * Represents a memory image of the assembler: all encoded instructions and
+ * operands, or all data words. The words are stored in fixed-size chunks
+ * that are allocated the first time one of their words is used; growing the
+ * image never moves the words already written.
+ *
+ * Fields:
+ *  chunks      - The chunk directory; chunk i holds addresses
+ *                i * MEMORY_CHUNK_WORDS up to (i + 1) * MEMORY_CHUNK_WORDS - 1.
+ *                Chunks not used yet are NULL.
+ *  chunk_count - The number of entries in the chunk directory.
+ */
+typedef struct {
+  memory_word **chunks;
+  int chunk_count;
+} memory;
+
+/*
+ * Function: init_memory_image
+ * ---------------------------
+ * Prepares an empty image. The chunk directory is presized for the given
+ * number of words; the chunks themselves are allocated when first used.
+ *
+ * Parameters:
+ *  image          - The image to initialise.
+ *  expected_words - The number of words the image is expected to hold.
+ */
+void init_memory_image(memory *image, size_t expected_words);
+
+/*
+ * Function: image_word
+ * --------------------
+ * Returns the word at the given address, growing the image if the address
+ * is beyond its current end. Words never written read as zero.
+ *
+ * Parameters:
+ *  image   - The image holding the word.
+ *  address - The non-negative address of the word.
+ *
+ * Returns:
+ *  A pointer to the word, valid for as long as the image.
  */
-typedef memory_word memory[MAX_MEM_SIZE];
+memory_word *image_word(memory *image, int address);
 
 #endif /* MEM_IMAGE_H */
\ No newline at end of file
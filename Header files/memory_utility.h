@@ -2,42 +2,139 @@
 #define MEMORY_UTILITY_H
 
 #include <stdio.h>
+#include <setjmp.h>
 
 /*
  * File: memory_utility.h
  * ----------------------
  * This header defines utility functions for managing dynamic memory
- * allocation and deallocation. It provides a safe memory allocation
- * mechanism and ensures that all dynamically allocated memory is
- * properly freed at the end of the program execution.
+ * allocation and deallocation. Memory is handed out from a region (arena)
+ * allocator: every allocation made while assembling one file is carved out
+ * of large chunks with a bump pointer, and the whole region is released in
+ * one step when the file is done. Each thread assembling a file binds an
+ * arena of its own, so parallel assemblies never share allocator state.
  *
  * Functions:
+ *  - arena_alloc: Bump-allocates memory from an arena.
+ *  - arena_free: Gives back the most recent allocation of an arena.
+ *  - arena_reset: Releases everything allocated from an arena at once.
+ *  - bind_arena: Gives the calling thread an arena of its own.
  *  - safe_alloc: Allocates memory and checks for allocation failure.
+ *  - safe_realloc: Grows a block previously returned by safe_alloc.
  *  - free_ptr: Frees a specific memory pointer.
  *  - free_all_memory: Frees all dynamically allocated memory.
  */
 
 /*
- * Struct: Memory_node
+ * Constant: ARENA_CHUNK_SIZE
+ * --------------------------
+ * The number of usable bytes in each chunk the arena requests from malloc.
+ * Requests larger than half a chunk get a dedicated chunk of their own.
+ */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/*
+ * Struct: Arena_chunk
  * -------------------
- * Represents a node in the memory tracking list.
- * Used for managing dynamically allocated memory pointers.
+ * A single block obtained from malloc. The usable payload follows the
+ * header directly in memory.
+ *
+ * Fields:
+ *  next_chunk - The previously filled chunk (chunks form a stack).
+ *  size       - Number of usable payload bytes.
+ *  used       - Number of payload bytes already handed out.
+ */
+typedef struct Arena_chunk {
+    struct Arena_chunk *next_chunk; /* Older chunk in the arena */
+    size_t size;                    /* Payload capacity in bytes */
+    size_t used;                    /* Payload bytes handed out */
+} Arena_chunk;
+
+/*
+ * Struct: Arena
+ * -------------
+ * A region allocator. Allocations are served from the current chunk by
+ * advancing a bump pointer; individual blocks are never freed, except that
+ * the most recent allocation may be given back or grown in place.
+ * A zero-initialised Arena is a valid empty arena.
  *
  * Fields:
- *  ptr        - A pointer to the allocated memory.
- *  next_node  - A pointer to the next node in the linked list (for tracking).
+ *  current    - The chunk allocations are currently carved from.
+ *  last       - The most recent allocation (NULL if it cannot be rolled back).
+ *  on_failure - Where safe_alloc jumps when the arena runs out of memory
+ *               (NULL to terminate the program instead).
+ */
+typedef struct Arena {
+    Arena_chunk *current; /* Chunk currently being bumped */
+    void *last;           /* Most recent allocation in the current chunk */
+    jmp_buf *on_failure;  /* Recovery point for allocation failures */
+} Arena;
+
+/*
+ * Function: arena_alloc
+ * ---------------------
+ * Allocates a suitably aligned block of the given size from the arena.
+ *
+ * Parameters:
+ *  arena - The arena to allocate from.
+ *  size  - The number of bytes to allocate.
+ *
+ * Returns:
+ *  A pointer to the block, or NULL if a new chunk could not be obtained.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/*
+ * Function: arena_free
+ * --------------------
+ * Gives a block back to the arena. Only the most recent allocation is
+ * actually reclaimed; any other block is released with the arena itself.
+ *
+ * Parameters:
+ *  arena - The arena the block was allocated from.
+ *  ptr   - The block to give back.
+ */
+void arena_free(Arena *arena, const void *ptr);
+
+/*
+ * Function: arena_reset
+ * ---------------------
+ * Releases every block allocated from the arena at once. The first chunk
+ * is kept so that the arena can be reused without going back to malloc.
+ *
+ * Parameters:
+ *  arena - The arena to reset.
+ */
+void arena_reset(Arena *arena);
+
+/*
+ * Function: arena_release
+ * -----------------------
+ * Returns every chunk owned by the arena to the system.
+ *
+ * Parameters:
+ *  arena - The arena to release.
  */
-typedef struct Memory_node {
-    void *ptr;                  /* Pointer to allocated memory */
-    struct Memory_node *next_node; /* Next node in memory tracking list */
-} Memory_node;
+void arena_release(Arena *arena);
+
+/*
+ * Function: bind_arena
+ * --------------------
+ * Makes safe_alloc, safe_realloc, free_ptr and free_all_memory use the given
+ * arena for the calling thread. Threads that bind no arena share a global one.
+ *
+ * Parameters:
+ *  arena - The arena to allocate from, or NULL for the global arena.
+ */
+void bind_arena(Arena *arena);
 
 /*
  * Function: safe_alloc
  * --------------------
- * Allocates memory of the specified size and checks if allocation
- * was successful. If allocation fails, it prints an error message
- * and exits the program.
+ * Allocates memory of the specified size from the calling thread's arena and
+ * checks if allocation was successful. If allocation fails, it prints an
+ * error message and jumps to the arena's recovery point, or exits the
+ * program if the arena has none.
  *
  * Parameters:
  *  size - The number of bytes to allocate.
@@ -47,11 +144,28 @@ typedef struct Memory_node {
  */
 void *safe_alloc(size_t size);
 
+/*
+ * Function: safe_realloc
+ * ----------------------
+ * Grows a block returned by safe_alloc. When the block is the most recent
+ * allocation it is extended in place, otherwise its contents are copied
+ * into a new block.
+ *
+ * Parameters:
+ *  ptr      - The block to grow.
+ *  old_size - The current size of the block.
+ *  new_size - The requested size of the block.
+ *
+ * Returns:
+ *  A pointer to the (possibly moved) block.
+ */
+void *safe_realloc(void *ptr, size_t old_size, size_t new_size);
+
 /*
  * Function: free_ptr
  * ------------------
- * Frees a specific memory pointer.
- * It is part of the utility to ensure memory is freed manually.
+ * Frees a specific memory pointer. Only the most recent allocation is
+ * reclaimed immediately; other blocks are reclaimed by free_all_memory.
  *
  * Parameters:
  *  ptr - A pointer to the memory block to be freed.
@@ -61,9 +175,10 @@ void free_ptr(const void *ptr);
 /*
  * Function: free_all_memory
  * --------------------------
- * Frees all dynamically allocated memory that has been tracked by the program.
- * This function should be called at the end of the program to avoid memory leaks.
+ * Frees all dynamically allocated memory that has been handed out by
+ * safe_alloc, in a single bulk release of the arena.
+ * This function should be called at the end of each file to avoid memory leaks.
  */
 void free_all_memory();
 
-#endif /* MEMORY_UTILITY_H */
\ No newline at end of file
+#endif /* MEMORY_UTILITY_H */
@@ -0,0 +1,155 @@
+#ifndef OBJECT_FILE_H
+#define OBJECT_FILE_H
+
+/*
+ * File: object_file.h
+ * -------------------
+ * This header defines the binary object file (.obb), an alternative to the
+ * textual .ob, .ent and .ext files for loaders and simulators. It holds the
+ * same result in a form that is used in place once mapped: a fixed header,
+ * the code and data words packed in 3 bytes each, the entry and external
+ * tables, the relocation records and the symbol names. Nothing has to be
+ * parsed; a reader maps the file, checks the header, finds the sections with
+ * locate_object_sections and reads the words with OBJECT_WORD.
+ *
+ * All numbers are stored in the byte order of the assembler that wrote the
+ * file, which byte_order tells a reader; the words are always little-endian.
+ *
+ * Layout (each section starts at a multiple of OBJECT_FILE_ALIGNMENT):
+ *  object_file_header
+ *  unsigned char[3 * code_size]          - The code words, from start_address.
+ *  unsigned char[3 * data_size]          - The data words, right after the code.
+ *  object_file_symbol[entry_count]       - The entries, in declaration order.
+ *  object_file_symbol[extern_count]      - The external references, in code order.
+ *  unsigned int[relocation_count]        - The addresses of the words to relocate.
+ *  char[names_length]                    - The names, each '\0'-terminated.
+ *
+ * Constants:
+ *  - OBJECT_FILE_MAGIC     : The first bytes of a .obb file.
+ *  - OBJECT_FILE_VERSION   : The version of the layout.
+ *  - OBJECT_FILE_ALIGNMENT : The alignment of each section.
+ *  - OBJECT_WORD_BYTES     : The bytes taken by each packed word.
+ *
+ * Macros:
+ *  - OBJECT_WORD : Reads a packed word.
+ *
+ * Types:
+ *  - object_file_header   : The header of a .obb file.
+ *  - object_file_symbol   : An entry or external reference.
+ *  - object_file_sections : Where each section starts.
+ *
+ * Functions:
+ *  - locate_object_sections    : Computes the section offsets from a header.
+ *  - create_binary_object_file : Writes the result of a context to its .obb file.
+ */
+
+#include "assembler.h"
+
+#define OBJECT_FILE_MAGIC "OBB"     /* With its '\0', the 4 first bytes of the file */
+#define OBJECT_FILE_VERSION 1       /* Bumped whenever the layout changes */
+#define OBJECT_FILE_ALIGNMENT 4     /* Sections start at multiples of this */
+#define OBJECT_WORD_BYTES 3         /* A 24-bit word, least significant byte first */
+
+/*
+ * Macro: OBJECT_WORD
+ * Reads word i of a packed code or data section.
+ *
+ * Parameters:
+ *  section - The section, as const unsigned char *.
+ *  i       - The index of the word in the section.
+ *
+ * Returns:
+ *  The 24-bit word, as an unsigned long.
+ */
+#define OBJECT_WORD(section, i)                                                      \
+  ((unsigned long)(section)[OBJECT_WORD_BYTES * (i)] |                               \
+   (unsigned long)(section)[OBJECT_WORD_BYTES * (i) + 1] << 8 |                      \
+   (unsigned long)(section)[OBJECT_WORD_BYTES * (i) + 2] << 16)
+
+/*
+ * Struct: object_file_header
+ * --------------------------
+ * The header of a .obb file.
+ *
+ * Fields:
+ *  magic            - OBJECT_FILE_MAGIC.
+ *  version          - OBJECT_FILE_VERSION.
+ *  byte_order       - 0x01020304 as written by the assembler that made the file.
+ *  start_address    - The address of the first code word (START_ADDRESS).
+ *  code_size        - The number of code words (ICF - start_address).
+ *  data_size        - The number of data words (DCF).
+ *  entry_count      - The number of entries.
+ *  extern_count     - The number of external references.
+ *  relocation_count - The number of relocation records.
+ *  names_length     - The number of characters in the names section.
+ */
+typedef struct {
+  char magic[4];
+  unsigned int version;
+  unsigned int byte_order;
+  unsigned int start_address;
+  unsigned int code_size;
+  unsigned int data_size;
+  unsigned int entry_count;
+  unsigned int extern_count;
+  unsigned int relocation_count;
+  unsigned int names_length;
+} object_file_header;
+
+/*
+ * Struct: object_file_symbol
+ * --------------------------
+ * An entry, or a reference to an external label, as in the .ent and .ext
+ * files.
+ *
+ * Fields:
+ *  name    - The offset of the name in the names section.
+ *  address - For an entry, the address of the label. For an external, the
+ *            address of the word referring to it.
+ */
+typedef struct {
+  unsigned int name;
+  unsigned int address;
+} object_file_symbol;
+
+/*
+ * Struct: object_file_sections
+ * ----------------------------
+ * The offset from the start of the file of each section, and the file size.
+ */
+typedef struct {
+  size_t code;
+  size_t data;
+  size_t entries;
+  size_t externals;
+  size_t relocations;
+  size_t names;
+  size_t end;
+} object_file_sections;
+
+/*
+ * Function: locate_object_sections
+ * --------------------------------
+ * Computes where the sections of a .obb file start from the counts in its
+ * header.
+ *
+ * Parameters:
+ *  header - The header of the file.
+ *  at     - Output: the offset of each section and the size of the file.
+ */
+void locate_object_sections(const object_file_header *header, object_file_sections *at);
+
+/*
+ * Function: create_binary_object_file
+ * -----------------------------------
+ * Writes the result of an assembly to the context's .obb file.
+ *
+ * Parameters:
+ *  ctx - The assembler context of the file, after the second pass.
+ *
+ * Returns:
+ *  NORMAL on success, ERROR if the file could not be written.
+ */
+enum errors create_binary_object_file(assembler_ctx *ctx);
+
+#endif /* OBJECT_FILE_H */
@@ -0,0 +1,99 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/*
+ * File: output.h
+ * --------------
+ * This header defines the output layer used to write the .ob, .ent and .ext
+ * files. Each file is formatted into one buffer by the fixed-width encoders
+ * below, which produce exactly what the "%07d", "%7d" and "%06lx" printf
+ * formats would, and the buffer is written to disk in a single call, under a
+ * temporary name that is then renamed to the file's.
+ *
+ * Constants:
+ *  - MAX_DECIMAL_DIGITS : The most digits put_decimal writes.
+ *  - HEX_WORD_DIGITS    : The digits put_hex_word writes.
+ *  - *_ADDRESS_WIDTH    : The width of the addresses in each output file.
+ *
+ * Functions:
+ *  - decimal_length    : Counts the characters put_decimal would write.
+ *  - put_decimal       : Formats a number in decimal, padded to a width.
+ *  - put_hex_word      : Formats a memory word in hexadecimal.
+ *  - write_output_file : Writes a formatted file in one call and renames it into place.
+ */
+
+#include <stddef.h>
+
+#define MAX_DECIMAL_DIGITS 20 /* Digits of the largest 64-bit unsigned long */
+#define HEX_WORD_DIGITS 6     /* Hexadecimal digits of a 24-bit word */
+#define OB_ADDRESS_WIDTH 7    /* "%07d" in the .ob file */
+#define ENT_ADDRESS_WIDTH 7   /* "%07d" in the .ent file */
+#define EXT_ADDRESS_WIDTH 7   /* "%7d" in the .ext file */
+
+/*
+ * Function: decimal_length
+ * ------------------------
+ * Counts the characters put_decimal writes for a number and a width, to size
+ * an output buffer.
+ *
+ * Parameters:
+ *  value - The number.
+ *  width - The minimum number of characters.
+ *
+ * Returns:
+ *  The larger of the number of digits of the value and the width.
+ */
+size_t decimal_length(unsigned long value, int width);
+
+/*
+ * Function: put_decimal
+ * ---------------------
+ * Formats a non-negative number in decimal, like printf's "%0*d" when the
+ * padding is '0' and "%*d" when it is ' '. The result is not '\0'-terminated.
+ *
+ * Parameters:
+ *  out   - Where to write the characters; room for the larger of the width
+ *          and MAX_DECIMAL_DIGITS is needed.
+ *  value - The number.
+ *  width - The minimum number of characters.
+ *  pad   - The character added on the left to reach the width.
+ *
+ * Returns:
+ *  The number of characters written.
+ */
+size_t put_decimal(char *out, unsigned long value, int width, char pad);
+
+/*
+ * Function: put_hex_word
+ * ----------------------
+ * Formats the low 24 bits of a memory word as 6 lowercase hexadecimal digits,
+ * like printf's "%06lx". The result is not '\0'-terminated.
+ *
+ * Parameters:
+ *  out  - Where to write the characters.
+ *  word - The word.
+ *
+ * Returns:
+ *  HEX_WORD_DIGITS.
+ */
+size_t put_hex_word(char *out, unsigned long word);
+
+/*
+ * Function: write_output_file
+ * ---------------------------
+ * Writes a text to a temporary file of its own with one write call and
+ * renames it over the file, so that the file is never seen partly written,
+ * even by a concurrent assembly of the same file. Nothing is left behind on
+ * failure.
+ *
+ * Parameters:
+ *  file_name - The name of the file.
+ *  text      - The contents of the file.
+ *  length    - The number of characters in the text.
+ *
+ * Returns:
+ *  1 on success, 0 if the file could not be created or written.
+ */
+int write_output_file(const char *file_name, const char *text, size_t length);
+
+#endif /* OUTPUT_H */
@@ -108,17 +108,20 @@ extern instruction instructions[];
 /*
  * Function: parse_string
  * ----------------------
- * Parses a string instruction and validates its syntax.
+ * Parses a string instruction and validates its syntax. The string is not
+ * copied: the result is a view of its characters in the line.
  *
  * Parameters:
- *  line       - The line containing the string instruction.
+ *  line       - The tokens of the line, positioned after the instruction.
+ *  length     - Output: the number of characters in the string.
  *  line_number - The line number for error reporting.
  *  status     - A pointer to the error status variable.
  *
  * Returns:
- *  A pointer to the parsed string, or NULL in case of an error.
+ *  A pointer to the first character of the string, or NULL in case of an error.
  */
-char *parse_string(char *line, int line_number, enum errors *status);
+const char *parse_string(const token_cursor *line, size_t *length, int line_number,
+                         enum errors *status);
 
 /*
  * Function: parse_linking_instruction
@@ -126,19 +129,35 @@ char *parse_string(char *line, int line_number, enum errors *status);
  * Parses a linking instruction (e.g., .extern, .entry) and validates its syntax.
  *
  * Parameters:
- *  line       - The line containing the linking instruction.
+ *  line       - The tokens of the line, positioned after the instruction.
  *  line_number - The line number for error reporting.
  *  status     - A pointer to the error status variable.
  *
  * Returns:
- *  A pointer to the parsed instruction name, or NULL in case of an error.
+ *  The interned name of the label, or NO_SYMBOL in case of an error.
  */
-char *parse_linking_instruction(char *line, int line_number, enum errors *status);
+unsigned int parse_linking_instruction(const token_cursor *line, int line_number, enum errors *status);
 
-int valid_label_char(char *work_line, int label_length);
-char *parse_linking_instruction(char *line, int line_number, enum errors *status);
-int parse_operation(char **work_line, int line_number,
+/*
+ * Function: parse_operation
+ * -------------------------
+ * Parses an operation and its operands from the tokens of a line and encodes
+ * them into up to MAX_OPERATION_LEN words.
+ *
+ * Parameters:
+ *  line         - The tokens of the line, positioned at the operation name.
+ *  line_number  - The line number for error reporting.
+ *  temp         - The words to encode the operation into.
+ *  errors       - A pointer to the error status variable.
+ *  source_label - Output: the interned label of the source operand, or NO_SYMBOL.
+ *  dest_label   - Output: the interned label of the destination operand, or NO_SYMBOL.
+ *
+ * Returns:
+ *  The number of words of the operation, or 0 after reporting an error and
+ *  setting *errors to ERROR.
+ */
+int parse_operation(token_cursor *line, int line_number,
                     memory_word temp[MAX_OPERATION_LEN], enum errors *errors,
-                    char **source_label, char **dest_label);
+                    unsigned int *source_label, unsigned int *dest_label);
 
 #endif /* PARSING_H */
\ No newline at end of file
@@ -14,13 +14,16 @@
  *
  * Functions:
  *  - preprocess: Handles the preprocessing of the input file.
- *  - mcro_start: Identifies the start of a macro definition.
- *  - mcro_end: Identifies the end of a macro definition and processes it.
+ *  - preprocess_text: Handles the preprocessing of source text held in memory.
+ *  - classify_line: Classifies a tokenized line by its first word.
  *  - is_reserved_name: Checks if a macro name is reserved.
  *  - insert_macro_name: Inserts a macro name into the macro table.
- *  - is_saved_macro: Checks if a macro has already been defined.
- *  - print_macro_contents_to_file: Writes macro contents to an output file.
- *  - append_line_to_macro: Appends a line to a macro's content.
+ *  - initialise_macro_table: Creates an empty macro table.
+ *  - find_macro: Looks a macro up by the interned id of its name.
+ *  - add_macro: Adds a named macro to the macro table.
+ *  - print_macro_contents: Appends macro contents to the expanded source.
+ *  - write_expanded_file: Writes the expanded source to the .am file.
+ *  - append_line_to_macro: Appends a tokenized line to a macro's content.
  */
 
 #define MACRO_START "mcro"      /* Identifier for macro start */
@@ -28,6 +31,9 @@
 
 /* Include the necessary headers */
 #include "errors.h"
+#include "input.h"
+#include "lexer.h"
+#include "assembler.h"
 #include <stdio.h>
 
 /**
@@ -37,59 +43,166 @@
  */
 extern char *reserved_names[28];
 
-typedef struct Macro_line{
-  char* line;
-  struct Macro_line *next_line;
-} Macro_line;
+/*
+ * Constant: MACRO_BODY_MIN_CAPACITY
+ * ---------------------------------
+ * The number of characters reserved for a macro body when its definition
+ * starts. The body doubles as needed.
+ */
+#define MACRO_BODY_MIN_CAPACITY 128
+
+/*
+ * Constant: MACRO_TABLE_MIN_CAPACITY
+ * ----------------------------------
+ * The number of slots a macro table starts with. The table doubles until
+ * it has a slot for the id of every macro name.
+ */
+#define MACRO_TABLE_MIN_CAPACITY 16
+
+/*
+ * Struct: Macro
+ * -------------
+ * A macro definition: its name and its body.
+ *
+ * Fields:
+ *  symbol      - The interned name of the macro.
+ *  macro_name  - The name of the macro ('\0'-terminated), owned by the interner.
+ *  body        - The lines of the body, each followed by a newline, in one
+ *                contiguous buffer ready to be copied into the output.
+ *  tokens      - The tokens of the body, line by line, with each line's
+ *                offset in the body; they are copied into the output with it.
+ */
+typedef struct Macro{
+  unsigned int symbol;
+  const char *macro_name;
+  text_buffer body;
+  token_stream tokens;
+} Macro;
 
+/*
+ * Struct: Macro_table
+ * -------------------
+ * The macros of a file, indexed by the interned id of their name, so a
+ * macro is found with one load and no string comparison.
+ *
+ * Fields:
+ *  slots    - Array of capacity pointers to macros (NULL for an empty slot).
+ *  capacity - The number of slots.
+ *  count    - The number of macros in the table.
+ *  symbols  - The interner naming the macros.
+ */
 typedef struct Macro_table{
-  char *macro_name;
-  Macro_line *first_line;
-  struct Macro_table *next_macro;
+  Macro **slots;
+  unsigned int capacity;
+  int count;
+  const interner *symbols;
 } Macro_table;
 
+/*
+ * Enum: line_kind
+ * ---------------
+ * The role of a source line for the preprocessor, decided by its first token.
+ *
+ *  LINE_OTHER       - Any other line, copied to the output as is.
+ *  LINE_MACRO_START - Starts a macro definition (MACRO_START name).
+ *  LINE_MACRO_END   - Ends a macro definition (MACRO_END).
+ *  LINE_MACRO_CALL  - Invokes a defined macro.
+ */
+typedef enum {
+  LINE_OTHER,
+  LINE_MACRO_START,
+  LINE_MACRO_END,
+  LINE_MACRO_CALL
+} line_kind;
+
+/*
+ * Struct: line_token
+ * ------------------
+ * The first word of a line, as found by classify_line: the run of tokens at
+ * the start of the line that are not separated by whitespace.
+ *
+ * Fields:
+ *  kind         - The kind of the line.
+ *  token        - The first word, a view into the classified line.
+ *  token_length - The number of characters in the first word.
+ *  rest         - The index of the first token after the first word. For
+ *                 LINE_MACRO_END, 0 if more text is glued to MACRO_END, so
+ *                 anything after MACRO_END leaves rest below the token count.
+ *  macro        - For LINE_MACRO_CALL, the invoked macro.
+ */
+typedef struct {
+  line_kind kind;
+  const char *token;
+  size_t token_length;
+  int rest;
+  Macro *macro;
+} line_token;
+
 
 /*
  * Function: preprocess
  * --------------------
  * Processes the input assembly file, scanning for macro definitions,
- * expanding macros, and preparing the file for further processing.
+ * expanding macros, and preparing the source for further processing.
+ * The macro table and the expanded source are stored in the context for
+ * the first pass; the expanded source is also written to the .am file when
+ * the context asks for it.
  *
  * Parameters:
- *  file_name - The name of the input file to preprocess.
+ *  ctx - The assembler context of the file being preprocessed.
  *
  * Returns:
- *  A pointer to the macro table containing all macros found in the file.
+ *  NORMAL on success, or ERROR if the source has macro errors or a file
+ *  could not be read or written.
  */
-Macro_table *preprocess(const char *file_name);
+enum errors preprocess(assembler_ctx *ctx);
 
 /*
- * Function: mcro_start
- * --------------------
- * Identifies the start of a macro definition, marked by the MACRO_START string.
+ * Function: preprocess_text
+ * -------------------------
+ * Preprocesses source text held in memory instead of a file. The macro table
+ * and the expanded source are stored in the context, as by preprocess.
  *
  * Parameters:
- *  line - The line being processed.
+ *  ctx    - The assembler context of the source.
+ *  source - The source text, in the format of a .as file.
+ *  length - The number of characters in source.
  *
  * Returns:
- *  1 if the line marks the start of a macro definition, 0 otherwise.
+ *  NORMAL on success, or ERROR if the source has macro errors.
  */
-int mcro_start(const char *line);
+enum errors preprocess_text(assembler_ctx *ctx, const char *source, size_t length);
 
 /*
- * Function: mcro_end
- * ------------------
- * Identifies the end of a macro definition and processes it. Marks the end of a macro.
+ * Function: write_expanded_file
+ * -----------------------------
+ * Writes the expanded source to the .am file, for debugging.
  *
  * Parameters:
- *  line        - The line being processed.
- *  ecode       - A pointer to the error status variable.
- *  line_number - The line number for error reporting.
+ *  file_name - The name of the source file, without extension.
+ *  expanded  - The expanded source.
  *
  * Returns:
- *  1 if the line marks the end of a macro definition, 0 otherwise.
+ *  1 on success, 0 if the file could not be written.
  */
-int mcro_end(const char *line, enum errors *ecode, const int line_number);
+int write_expanded_file(const char *file_name, const text_buffer *expanded);
+
+/*
+ * Function: classify_line
+ * -----------------------
+ * Classifies a tokenized line by its first word: macro start, macro end,
+ * macro invocation or anything else. Only the tokens of the first word are
+ * looked at, so preprocessing stays linear in the size of the input.
+ *
+ * Parameters:
+ *  line  - The tokens of the line being processed.
+ *  table - The macro table, or NULL to ignore macro invocations.
+ *  word  - Output: the first word and where the rest of the line starts.
+ *
+ * Returns:
+ *  The kind of the line.
+ */
+line_kind classify_line(const token_cursor *line, const Macro_table *table, line_token *word);
 
 /*
  * Function: is_reserved_name
@@ -102,57 +215,93 @@ int mcro_end(const char *line, enum errors *ecode, const int line_number);
  * Returns:
  *  1 if the macro name is reserved, 0 otherwise.
  */
-int is_reserved_name(char *mcro_name);
+int is_reserved_name(const char *mcro_name);
 
 /*
  * Function: insert_macro_name
  * ---------------------------
- * Inserts the macro name into the macro table. This function is called when a new
- * macro is encountered.
+ * Reads the name of a new macro from its definition line, interns it and
+ * stores it in the macro. The name is left NULL if the line is malformed.
  *
  * Parameters:
- *  line        - The line containing the macro name.
- *  curr_macro  - A pointer to the current macro table.
+ *  line        - The tokens of the definition line.
+ *  start       - The classified definition line.
+ *  curr_macro  - The macro being defined.
  *  ecode       - A pointer to the error status variable.
  *  line_number - The line number of the macro definition.
  */
-void insert_macro_name(const char *line, struct Macro_table *curr_macro, enum errors *ecode, int line_number);
+void insert_macro_name(const token_cursor *line, const line_token *start, Macro *curr_macro,
+                       enum errors *ecode, int line_number);
 
 /*
- * Function: is_saved_macro
- * ------------------------
- * Checks if the macro is already saved in the macro table.
+ * Function: initialise_macro_table
+ * --------------------------------
+ * Creates an empty macro table.
  *
  * Parameters:
- *  line  - The line containing the macro name.
- *  head  - The head of the macro table.
+ *  symbols - The interner of the source, which names the macros.
  *
  * Returns:
- *  1 if the macro is already saved, 0 otherwise.
+ *  A pointer to the new table.
  */
-int is_saved_macro(const char *line, struct Macro_table *head);
+Macro_table *initialise_macro_table(const interner *symbols);
 
 /*
- * Function: print_macro_contents_to_file
- * --------------------------------------
- * Writes the contents of a macro to an output file.
+ * Function: find_macro
+ * --------------------
+ * Looks a macro up by the interned id of its name.
+ *
+ * Parameters:
+ *  table  - The macro table.
+ *  symbol - The interned name, or NO_SYMBOL for a name that was never
+ *           interned (and so cannot be a macro).
+ *
+ * Returns:
+ *  The macro with that name, or NULL if there is none.
+ */
+Macro *find_macro(const Macro_table *table, unsigned int symbol);
+
+/*
+ * Function: add_macro
+ * -------------------
+ * Adds a macro with a name to the table. A macro whose name is already
+ * defined is not added, so the first definition of a name stays in effect.
+ *
+ * Parameters:
+ *  table - The macro table.
+ *  macro - The macro to add; its symbol must be set.
+ *
+ * Returns:
+ *  1 if the macro was added, 0 if the name was already defined.
+ */
+int add_macro(Macro_table *table, Macro *macro);
+
+/*
+ * Function: print_macro_contents
+ * ------------------------------
+ * Appends the contents of a macro and their tokens to the expanded source,
+ * with one copy of each.
  *
  * Parameters:
- *  macro_idx     - The index of the macro in the macro table.
- *  head_macro    - The head of the macro table.
- *  output        - The output file to write the macro contents.
+ *  macro  - The macro to expand.
+ *  output - The buffer holding the expanded source.
+ *  tokens - The tokens of the expanded source.
  */
-void print_macro_contents_to_file(const int macro_idx, struct Macro_table *head_macro, FILE *output);
+void print_macro_contents(const Macro *macro, text_buffer *output, token_stream *tokens);
 
 /*
  * Function: append_line_to_macro
  * ------------------------------
- * Appends a line of text to the current macro's content.
+ * Appends a line of text, followed by a newline, to the body of the current
+ * macro, and records the line's tokens, which must be the last tokens of
+ * the macro's token stream.
  *
  * Parameters:
  *  line        - The line of text to append.
+ *  length      - The number of characters in the line.
+ *  token_count - The number of tokens on the line.
  *  curr_macro  - The current macro being processed.
  */
-void append_line_to_macro(char *line, struct Macro_table *curr_macro);
+void append_line_to_macro(const char *line, size_t length, int token_count, Macro *curr_macro);
 
 #endif /* PREPROCESSOR_H */
\ No newline at end of file
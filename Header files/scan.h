@@ -0,0 +1,36 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+/*
+ * File: scan.h
+ * ------------
+ * This header declares the scanning kernel of the input layer: skipping
+ * whitespace. It is the innermost loop of the lexer, so on x86 with GCC or
+ * Clang a long run of whitespace is compared 16 (SSE2) or 32 (AVX2) bytes at
+ * a time; which version runs is chosen at run time from the CPU's features.
+ * Elsewhere a portable byte loop is used. All versions return the same
+ * results and never read past the given length.
+ *
+ * Functions:
+ *  - skip_spaces  : Finds the first character of a text that is not whitespace.
+ */
+
+#include <stddef.h>
+
+/*
+ * Function: skip_spaces
+ * ---------------------
+ * Finds the first character of a text that is not whitespace, as classified
+ * by CHAR_SPACE.
+ *
+ * Parameters:
+ *  text   - The text.
+ *  length - The number of characters in the text.
+ *
+ * Returns:
+ *  The index of the first character that is not whitespace, or length if the
+ *  text is blank.
+ */
+size_t skip_spaces(const char *text, size_t length);
+
+#endif /* SCAN_H */
@@ -5,14 +5,18 @@
  * File: second_pass.h
  * -------------------
  * This header defines the functions used during the second pass of the assembler.
- * The second pass involves resolving labels, creating the final object files, and
- * generating the entry file. It processes the intermediate code generated during
- * the first pass and performs actions like label population and file creation.
+ * The second pass resolves labels and lays out the final object words, entries and
+ * externals in the context's result, entirely in memory. The create_*_file
+ * functions are the file-based front end writing that result to the output files.
  *
  * Functions:
+ *  - second_pass: Runs the second pass, filling the context's result.
  *  - populate_labels: Resolves and populates labels in the code memory.
- *  - create_entry_file: Creates the entry file based on the entry table.
- *  - create_ob_file: Creates the object file containing the final code and data.
+ *  - collect_entries: Lists the entry labels with their addresses.
+ *  - collect_object_words: Lays out the final code and data words.
+ *  - create_extern_file: Creates the extern file from the result.
+ *  - create_entry_file: Creates the entry file from the result.
+ *  - create_ob_file: Creates the object file from the result.
  */
 
 #include "file_extensions.h"
@@ -21,41 +25,89 @@
 #include "parsing.h"
 #include "tables.h"
 #include "mem_image.h"
+#include "assembler.h"
 #include <stdio.h>
 #include <string.h>
 
+/*
+ * Function: second_pass
+ * ---------------------
+ * Resolves the label references and fills the context's result with the
+ * object words, entries and externals.
+ *
+ * Parameters:
+ *  ctx - The assembler context of the file, after the first pass.
+ *
+ * Returns:
+ *  NORMAL when the result is complete.
+ */
+enum errors second_pass(assembler_ctx *ctx);
+
 /*
  * Function: populate_labels
  * -------------------------
- * Resolves labels in the assembly code. This function processes the input file
- * to assign addresses to labels in the code and data sections.
+ * Resolves labels in the assembly code. This function assigns the addresses
+ * of the labels in the context's label table to the code words referring to
+ * them and records in the result each reference to an external label and
+ * each word that needs relocating.
  *
  * Parameters:
- *  file_name        - The name of the file being processed.
- *  code             - A pointer to the memory that will hold the assembled code.
- *  label_table      - The table of labels to resolve.
- *  intern_table     - The table of interned labels.
- *  ICF              - The initial code address for the code section.
+ *  ctx - The assembler context of the file, after the first pass.
  */
-void populate_labels(const char *file_name, memory code,
-                     label_table_head label_table,
-                     intern_table_head intern_table, int ICF);
+void populate_labels(assembler_ctx *ctx);
+
+/*
+ * Function: collect_entries
+ * -------------------------
+ * Records the name and address of every label declared with .entry in the
+ * context's result.
+ *
+ * Parameters:
+ *  ctx - The assembler context of the file, after the first pass.
+ */
+void collect_entries(assembler_ctx *ctx);
+
+/*
+ * Function: collect_object_words
+ * ------------------------------
+ * Copies the code image followed by the data image into the context's
+ * result, in load order.
+ *
+ * Parameters:
+ *  ctx - The assembler context of the file, after the labels are populated.
+ */
+void collect_object_words(assembler_ctx *ctx);
+
+/*
+ * Function: create_extern_file
+ * ----------------------------
+ * Creates the extern file listing every reference to an external label.
+ * No file is written when there are none, and an earlier one is removed if
+ * ctx->remove_stale is set.
+ *
+ * Parameters:
+ *  ctx - The assembler context of the file, after the second pass.
+ *
+ * Returns:
+ *  NORMAL on success, ERROR if the extern file could not be created.
+ */
+enum errors create_extern_file(assembler_ctx *ctx);
 
 /*
  * Function: create_entry_file
  * ---------------------------
  * Creates the entry file that lists all entry points in the assembly program.
  * An entry point is a label that is used in the code to indicate a function or
- * a location to jump to.
+ * a location to jump to. No file is written when there are none, and an
+ * earlier one is removed if ctx->remove_stale is set.
  *
  * Parameters:
- *  file_name       - The name of the file being processed.
- *  label_table     - The table of labels to check for entry points.
- *  entry_table     - The table of entry points to be written to the entry file.
- *  ICF             - The initial code address (to ensure proper entry addresses).
+ *  ctx - The assembler context of the file, after the second pass.
+ *
+ * Returns:
+ *  NORMAL on success, ERROR if the entry file could not be created.
  */
-void create_entry_file(const char *file_name, label_table_head label_table,
-                       entry_table_head entry_table, int ICF);
+enum errors create_entry_file(assembler_ctx *ctx);
 
 /*
  * Function: create_ob_file
@@ -65,13 +117,11 @@ void create_entry_file(const char *file_name, label_table_head label_table,
  * and is used in the final stages of the assembly process.
  *
  * Parameters:
- *  file_name       - The name of the file being processed.
- *  code            - A pointer to the memory holding the assembled code.
- *  data            - A pointer to the memory holding the assembled data.
- *  ICF             - The initial code address.
- *  DCF             - The initial data address.
+ *  ctx - The assembler context of the file, after the second pass.
+ *
+ * Returns:
+ *  NORMAL on success, ERROR if the object file could not be created.
  */
-void create_ob_file(const char *file_name, const memory code,
-                    const memory data, const int ICF, const int DCF);
+enum errors create_ob_file(assembler_ctx *ctx);
 
 #endif /* SECOND_PASS_H */
\ No newline at end of file
@@ -2,18 +2,21 @@
 #define TABLES_H
 
 #include "errors.h"
+#include "interner.h"
+#include "mem_image.h"
 #include <stddef.h>
 #include <stdlib.h>
 
 /*
  * Enum: label_data_type
  * ---------------------
- * Defines the types of labels in the assembler (DATA, CODE, EXTERNAL).
+ * Defines the types of labels in the assembler (DATA, CODE, EXTERNAL, UNDEFINED).
  * - DATA: Labels that are associated with data.
  * - CODE: Labels that are part of the executable code.
  * - EXTERNAL: Labels that are externals (linked from other modules).
+ * - UNDEFINED: Labels that are referenced but not defined (yet).
  */
-typedef enum { DATA, CODE, EXTERNAL } label_data_type;
+typedef enum { DATA, CODE, EXTERNAL, UNDEFINED } label_data_type;
 
 /*
  * Enum: linking_type
@@ -24,81 +27,155 @@ typedef enum { DATA, CODE, EXTERNAL } label_data_type;
  */
 typedef enum { DEFAULT, EXTERN } linking_type;
 
+/*
+ * Constant: LABEL_TABLE_MIN_CAPACITY
+ * ----------------------------------
+ * The smallest number of labels a label table is created with room for.
+ */
+#define LABEL_TABLE_MIN_CAPACITY 64
+
+/*
+ * Constant: SOURCE_BYTES_PER_LABEL
+ * --------------------------------
+ * A conservative estimate of how many bytes of source text there are for each
+ * label, used to presize the interner from the input file length.
+ */
+#define SOURCE_BYTES_PER_LABEL 32
+
+/*
+ * Constant: NO_FIXUP
+ * ------------------
+ * Ends a chain of pending references.
+ */
+#define NO_FIXUP (-1)
+
 /*
  * Structure: label_node
  * ---------------------
- * A node that represents a label in the label table.
- * Each label node contains the label's name, value, type, and linking type.
+ * A slot of the label table. The slot of a label is the interned id of its
+ * name, so a label is found by indexing rather than by hashing or comparing
+ * its name. A slot whose symbol is not its own index is empty. A label that is
+ * referenced before it is defined holds its slot with the type UNDEFINED, and
+ * the references waiting for its address are chained from the slot.
  */
 typedef struct node {
-  const char *name;                    /* The name of the label */
+  unsigned int symbol;                 /* The interned name of the label */
   int value;                           /* The value associated with the label */
-  label_data_type type;                /* Type of label (DATA, CODE, EXTERNAL) */
+  label_data_type type;                /* Type of label (DATA, CODE, EXTERNAL, UNDEFINED) */
   linking_type linking_type;           /* Linking type (DEFAULT or EXTERN) */
-  struct node *right;                  /* Right child node in binary tree */
-  struct node *left;                   /* Left child node in binary tree */
+  int fixups;                          /* First pending reference to the label, or NO_FIXUP */
 } label_node;
 
-/* Label table head - points to the root of the binary search tree of labels */
+/* Label table head - the labels of a source, indexed by the interned id of their name */
 typedef struct {
-  label_node *root;                   /* Root of the label binary search tree */
+  label_node *slots;                  /* Array of capacity slots */
+  unsigned int capacity;              /* Number of slots */
+  const interner *symbols;            /* The interner naming the labels */
 } label_table_head;
 
 /**
  * @brief Initialises an empty label table and allocates it dynamically.
  *
+ * The table has a slot for every symbol interned so far, so it only grows if
+ * more names are interned later.
+ *
+ * @param symbols the interner of the source, which names the labels
+ *
  * @return A pointer to the dynamically allocated label table.
  */
-label_table_head *initialise_label_table();
+label_table_head *initialise_label_table(const interner *symbols);
 
 /**
- * @brief Adds a new label to the label table assuming that the label name is not already taken.
+ * @brief Returns the slot of a label that is referenced, claiming it if it is empty.
+ *
+ * A claimed slot holds an UNDEFINED label with no pending references. Claiming
+ * may grow the table, which invalidates previously returned nodes.
+ *
+ * @param head the table holding the label
+ * @param symbol the interned name of the label
+ *
+ * @return A pointer to the slot of the label.
+ */
+label_node *reference_label(label_table_head *head, unsigned int symbol);
+
+/**
+ * @brief Looks a label up by name and inserts it if it is missing.
+ *
+ * A newly inserted label only has its name and pending references set; the
+ * caller fills in the rest.
+ * Inserting may grow the table, which invalidates previously returned nodes.
+ *
+ * @param head the table to search and insert into
+ * @param symbol the interned name of the label
+ * @param found set to 1 if the label was already defined, 0 if it was inserted
+ *
+ * @return A pointer to the existing or newly inserted label.
+ */
+label_node *find_or_add_label(label_table_head *head, unsigned int symbol, int *found);
+
+/**
+ * @brief Adds a new label to the label table unless the label name is already taken.
  *
  * @param head the table to add the label to
- * @param name the name of the label
+ * @param symbol the interned name of the label
  * @param value the value of the label
  * @param type the type of label (DATA or CODE)
  * @param linking_type the linking type of the label (DEFAULT or EXTERN)
+ *
+ * @return 1 if the label was added, 0 if a label with that name already exists.
  */
-void add_label(label_table_head *head, const char *name, int value,
-               label_data_type type, linking_type linking_type);
+int add_label(label_table_head *head, unsigned int symbol, int value,
+              label_data_type type, linking_type linking_type);
 
 /**
- * @brief Searches the label table for a label matching the name provided.
+ * @brief Finds the label with the name provided.
  *
- * @param name the name of the label to search for
+ * @param symbol the interned name of the label to search for
  * @param head the label table to search in
  *
  * @return A pointer to the label object containing the name and value of the label
- *         or NULL if no matching label was found.
+ *         or NULL if no label of that name is defined.
  */
-label_node *find_label(const char *name, label_table_head head);
+label_node *find_label(unsigned int symbol, label_table_head head);
 
 /*
  * Enum: intern_type
  * -----------------
- * Defines the types of interned labels (immediate or relative).
+ * Defines the types of interned labels (immediate, relative or resolved).
  * - immediate: The label is inserted with an immediate reference in memory.
  * - relative: The label is inserted with a relative reference in memory.
+ * - resolved: The reference was patched when its label was defined.
+ */
+typedef enum { immediate, relative, resolved } intern_type;
+
+/*
+ * Constant: TABLE_STARTING_CAPACITY
+ * ---------------------------------
+ * The number of records the intern and entry tables are created with.
+ * Both tables double their capacity whenever they fill up.
  */
-typedef enum { immediate, relative } intern_type;
+#define TABLE_STARTING_CAPACITY 64
 
 /*
  * Structure: intern_node
  * ----------------------
- * A node representing an interned label. Interned labels are used to resolve
- * addresses during the assembly process (either immediate or relative).
+ * A record representing a reference to a label whose address was not known when
+ * the reference was read. The records of a label are chained from its slot in
+ * the label table, and patched when the label is defined or at the end of the
+ * source (either immediate or relative).
  */
 typedef struct intern {
-  char *name;                  /* The name of the interned label */
-  intern_type type;            /* The type of interned label (immediate or relative) */
+  unsigned int symbol;         /* The interned name of the label */
+  intern_type type;            /* The type of reference (immediate, relative or resolved) */
   int mem_place;               /* The memory location associated with the interned label */
-  struct intern *next_intern;  /* Pointer to the next intern node */
+  int next;                    /* Next pending reference to the same label, or NO_FIXUP */
 } intern_node;
 
-/* Intern table head - points to the root of the interned labels list */
+/* Intern table head - a growable array of intern records, in insertion order */
 typedef struct {
-  intern_node *root;           /* Root of the interned labels list */
+  intern_node *items;          /* The intern records */
+  int count;                   /* Number of records in use */
+  int capacity;                /* Number of records allocated */
 } intern_table_head;
 
 /**
@@ -109,50 +186,59 @@ typedef struct {
 intern_table_head *initialise_intern_table();
 
 /**
- * @brief Adds a new interned label to the intern table.
+ * @brief Appends a new interned label to the intern table in amortised constant time.
  *
- * @param name the name of the interned label
- * @param type the type of interned label (immediate or relative)
+ * @param head the intern table to add the interned label to
+ * @param symbol the interned name of the label
  * @param mem_place the memory place associated with the interned label
- * @param table the intern table to add the interned label to
- *
- * @return A pointer to the newly added interned label.
+ * @param type the type of interned label (immediate or relative)
  */
-intern_node *add_intern(char *name, intern_type type, int mem_place, intern_node table);
+void add_new_intern(intern_table_head *head, unsigned int symbol, int mem_place, intern_type type);
 
 /**
- * @brief Adds a new interned label to the intern table.
+ * @brief Resolves a reference to a label in a code word.
  *
- * @param head the intern table to add the interned label to
- * @param name the name of the interned label
- * @param mem_place the memory place associated with the interned label
- * @param type the type of interned label (immediate or relative)
+ * A reference whose value is already known - a code label defined earlier, or
+ * a relative reference to a data label - is patched at once. Any other
+ * reference is appended to the intern table and chained from the label's slot,
+ * to be patched when the label is defined or at the end of the source.
+ *
+ * @param head the intern table holding the pending references
+ * @param labels the label table
+ * @param code_image the code image holding the word
+ * @param symbol the interned name of the label
+ * @param mem_place the address of the word referring to the label
+ * @param type the type of reference (immediate or relative)
  */
-void add_new_intern(intern_table_head *head, char *name, int mem_place, intern_type type);
+void add_reference(intern_table_head *head, label_table_head *labels, memory *code_image,
+                   unsigned int symbol, int mem_place, intern_type type);
 
 /**
- * @brief Checks for the presence of interned labels in the label table.
+ * @brief Patches the pending references to a label that was just defined.
  *
- * @param intern_head the intern table to check
- * @param label_head the label table to check against
+ * References that still need the end of the source (immediate references to
+ * data and external labels) stay chained from the label.
  *
- * @return 1 if intern labels are present in the label table, 0 otherwise.
+ * @param head the intern table holding the pending references
+ * @param label the label that was defined
+ * @param code_image the code image holding the words
  */
-int check_interns_in_labels(intern_table_head *intern_head, label_table_head *label_head);
+void resolve_references(intern_table_head *head, label_node *label, memory *code_image);
 
 /*
  * Structure: entry_node
  * ---------------------
- * Represents an entry in the entry table. Each entry node contains the name of the entry.
+ * Represents an entry in the entry table. Each entry record contains the name of the entry.
  */
 typedef struct entry {
-  char *name;                    /* The name of the entry */
-  struct entry *next_entry;       /* Pointer to the next entry node */
+  unsigned int symbol;           /* The interned name of the entry */
 } entry_node;
 
-/* Entry table head - points to the root of the entry list */
+/* Entry table head - a growable array of entry records, in insertion order */
 typedef struct {
-  entry_node *root;               /* Root of the entry list */
+  entry_node *items;              /* The entry records */
+  int count;                      /* Number of records in use */
+  int capacity;                   /* Number of records allocated */
 } entry_table_head;
 
 /**
@@ -163,29 +249,11 @@ typedef struct {
 entry_table_head *initialise_entry_table();
 
 /**
- * @brief Adds a new entry to the entry table.
- *
- * @param name the name of the entry to add
- * @param table the entry table to add the entry to
- *
- * @return A pointer to the newly added entry node.
- */
-entry_node *add_entry(char *name, entry_node table);
-
-/**
- * @brief Adds an entry node to the entry table.
- *
- * @param node the entry node to add
- * @param curr the current entry node in the table
- */
-void add_entry_node(entry_node *node, entry_node *curr);
-
-/**
- * @brief Adds a new entry to the entry table.
+ * @brief Appends a new entry to the entry table in amortised constant time.
  *
  * @param head the entry table to add the entry to
- * @param name the name of the entry to add
+ * @param symbol the interned name of the entry to add
  */
-void add_new_entry(entry_table_head *head, char *name);
+void add_new_entry(entry_table_head *head, unsigned int symbol);
 
-#endif /*TABLES_H*/
\ No newline at end of file
+#endif /*TABLES_H*/
@@ -0,0 +1,177 @@
+#ifndef TOKEN_FILE_H
+#define TOKEN_FILE_H
+
+/*
+ * File: token_file.h
+ * ------------------
+ * This header defines the .amt file, a binary form of the preprocessor's
+ * output. Where the .am file holds the expanded source as text, the .amt
+ * file holds it already lexed: the token stream, the strings of the interned
+ * symbols, the ids of the macro names and the expanded text itself. Each
+ * section is stored in the layout the assembler uses in memory, so loading
+ * the file is a single mmap and the first pass reads the tokens straight out
+ * of the mapping; nothing is lexed or copied, and the only work besides
+ * rebuilding the symbol index is one checksum pass over the file.
+ *
+ * The file records the size and a 64-bit digest of the .as file it was made
+ * from. It is only used while the source is unchanged, and only by the build
+ * that wrote it: a file with another version, byte order or token layout is
+ * ignored and the source is preprocessed again. A 64-bit checksum over the
+ * whole file is checked with the header and the section bounds before
+ * anything is used, so a truncated or damaged file is also ignored. A change
+ * to a single 32-bit word is always caught; other damage goes unnoticed with
+ * odds of about 1 in 2^64. The records are not checked one by one, so the
+ * checksum guards against damage, not against a file crafted to pass it.
+ *
+ * Layout (each section starts at a multiple of TOKEN_FILE_ALIGNMENT):
+ *  token_file_header
+ *  token_file_string[symbol_count] - The interned symbols, in id order.
+ *  unsigned int[macro_count]       - The interned names of the macros.
+ *  token[token_count]              - The tokens of the expanded source.
+ *  token_line[line_count]          - The lines of the expanded source.
+ *  char[strings_length]            - The strings, each '\0'-terminated.
+ *  char[text_length + 1]           - The expanded source, '\0'-terminated.
+ *
+ * Constants:
+ *  - TOKEN_FILE_MAGIC     : The first bytes of a .amt file.
+ *  - TOKEN_FILE_VERSION   : The version of the layout.
+ *  - TOKEN_FILE_ALIGNMENT : The alignment of each section.
+ *  - SOURCE_DIGEST_WORDS  : The number of 32-bit words in a source digest.
+ *
+ * Types:
+ *  - token_file_header : The header of a .amt file.
+ *  - token_file_string : An interned symbol.
+ *
+ * Functions:
+ *  - digest_source    : Computes the digest of a .as file.
+ *  - write_token_file : Writes the preprocessed source to the .amt file.
+ *  - load_token_file  : Maps a .amt file in place of preprocessing.
+ *  - close_token_file : Unmaps the .amt file of a context.
+ */
+
+#include "assembler.h"
+
+#define TOKEN_FILE_MAGIC "AMT"     /* With its '\0', the 4 first bytes of the file */
+#define TOKEN_FILE_VERSION 4       /* Bumped whenever the layout changes */
+#define TOKEN_FILE_ALIGNMENT 8     /* Sections start at multiples of this */
+#define SOURCE_DIGEST_WORDS 2      /* 32 bits in each word, 64 in all */
+
+/*
+ * Struct: token_file_header
+ * -------------------------
+ * The header of a .amt file.
+ *
+ * Fields:
+ *  magic          - TOKEN_FILE_MAGIC.
+ *  version        - TOKEN_FILE_VERSION.
+ *  byte_order     - 0x01020304 as written by the assembler that made the file.
+ *  token_size     - sizeof(token) of that assembler.
+ *  line_size      - sizeof(token_line) of that assembler.
+ *  symbol_count   - The number of interned symbols.
+ *  macro_count    - The number of macros.
+ *  token_count    - The number of tokens.
+ *  line_count     - The number of lines.
+ *  source_size    - The size of the .as file.
+ *  source_digest  - The digest_source digest of the .as file.
+ *  strings_length - The number of characters in the strings section.
+ *  text_length    - The number of characters in the expanded source.
+ *  checksum       - The checksum of the whole file, taken with this field zero.
+ */
+typedef struct {
+  char magic[4];
+  unsigned int version;
+  unsigned int byte_order;
+  unsigned int token_size;
+  unsigned int line_size;
+  unsigned int symbol_count;
+  unsigned int macro_count;
+  int token_count;
+  int line_count;
+  unsigned long source_size;
+  unsigned long source_digest[SOURCE_DIGEST_WORDS];
+  unsigned long strings_length;
+  unsigned long text_length;
+  unsigned long checksum[SOURCE_DIGEST_WORDS];
+} token_file_header;
+
+/*
+ * Struct: token_file_string
+ * -------------------------
+ * An interned symbol: a string of the strings section.
+ *
+ * Fields:
+ *  offset - The offset of the string in the strings section.
+ *  length - The number of characters in the string.
+ *  hash   - The hash_text hash of the string.
+ */
+typedef struct {
+  unsigned long offset;
+  unsigned long length;
+  unsigned long hash;
+} token_file_string;
+
+/*
+ * Function: digest_source
+ * -----------------------
+ * Computes the 64-bit digest the .amt file is keyed on: two 32-bit hashes of
+ * the source, FNV-1a and a rotate-multiply hash, which mix the bytes
+ * differently. A source that is edited but keeps its size and its digest
+ * would reuse stale tokens; for an accidental edit the odds are about 1 in
+ * 2^64.
+ *
+ * Parameters:
+ *  text   - The .as file.
+ *  length - The number of characters in it.
+ *  digest - Output: the digest.
+ */
+void digest_source(const char *text, size_t length, unsigned long digest[SOURCE_DIGEST_WORDS]);
+
+/*
+ * Function: write_token_file
+ * --------------------------
+ * Writes the macro table, the interner, the token stream and the expanded
+ * source of a preprocessed context to the .amt file.
+ *
+ * Parameters:
+ *  ctx           - The context, after preprocessing.
+ *  source_size   - The size of the .as file.
+ *  source_digest - The digest_source digest of the .as file.
+ *
+ * Returns:
+ *  1 on success, 0 if the file could not be written.
+ */
+int write_token_file(const assembler_ctx *ctx, unsigned long source_size,
+                     const unsigned long source_digest[SOURCE_DIGEST_WORDS]);
+
+/*
+ * Function: load_token_file
+ * -------------------------
+ * Maps the .amt file of a context and sets the context up as if its source
+ * had just been preprocessed: the token stream and the expanded source point
+ * into the mapping, the interner and the macro table refer to its strings.
+ * The mapping stays in place until close_token_file.
+ *
+ * Parameters:
+ *  ctx           - The context, before preprocessing.
+ *  source_size   - The size of the .as file.
+ *  source_digest - The digest_source digest of the .as file.
+ *
+ * Returns:
+ *  1 if the file was loaded, 0 if it is missing, stale, damaged or unusable,
+ *  in which case only the context's interner may have been touched, and
+ *  preprocessing sets it up again.
+ */
+int load_token_file(assembler_ctx *ctx, unsigned long source_size,
+                    const unsigned long source_digest[SOURCE_DIGEST_WORDS]);
+
+/*
+ * Function: close_token_file
+ * --------------------------
+ * Unmaps the .amt file loaded into a context, if any.
+ *
+ * Parameters:
+ *  ctx - The context.
+ */
+void close_token_file(assembler_ctx *ctx);
+
+#endif /* TOKEN_FILE_H */
@@ -4,37 +4,39 @@
 int is_data_instruction(inst instruction_type);
 int is_linking_instruction(inst instruction_type);
 int is_empty(op_type type);
-int is_register(char *operand);
+int is_register(const token_cursor *line, int first, int end);
 
 
 /*
  * Function: is_instruction
  * ------------------------
- * Checks if the line contains a valid instruction. It also sets the instruction
- * type and provides the line number for error reporting.
+ * Checks if the next tokens of the line are an instruction ('.' and its name),
+ * consuming them. It also sets the instruction type and provides the line
+ * number for error reporting.
  *
  * Parameters:
- *  line              - A pointer to the line being analyzed.
+ *  line              - The tokens of the line being analyzed.
  *  instruction_type  - A pointer to the variable where the instruction type will be stored.
  *  line_number       - The line number of the instruction for error reporting.
  *
  * Returns:
  *  1 if the line contains a valid instruction, 0 otherwise.
  */
-int is_instruction(char **line, inst *instruction_type, int line_number);
+int is_instruction(token_cursor *line, inst *instruction_type, int line_number);
 
 /*
  * Function: is_whitespace
  * -----------------------
- * Checks if the line consists only of whitespace characters (spaces, tabs, etc.).
+ * Checks if nothing but whitespace (spaces, tabs, etc.) is left on the line,
+ * that is if the line has no tokens left.
  *
  * Parameters:
- *  line - The line to check.
+ *  line - The tokens of the line to check.
  *
  * Returns:
- *  1 if the line is empty or only contains whitespace, 0 otherwise.
+ *  1 if the rest of the line is empty or only contains whitespace, 0 otherwise.
  */
-int is_whitespace(const char *line);
+int is_whitespace(const token_cursor *line);
 
 /*
  * Function: is_comment
@@ -42,27 +44,43 @@ int is_whitespace(const char *line);
  * Checks if the line is a comment (starts with a comment character).
  *
  * Parameters:
- *  line - The line to check.
+ *  line - The tokens of the line to check.
  *
  * Returns:
  *  1 if the line is a comment, 0 otherwise.
  */
-int is_comment(const char *line);
+int is_comment(const token_cursor *line);
 
 /*
  * Function: is_label
  * ------------------
- * Checks if the line starts with a label. A label is followed by a colon
- * and can be placed at the beginning of a line.
+ * Checks if the line starts with a label, consuming it. A label is an
+ * identifier with a colon glued to it and can be placed at the beginning of
+ * a line.
  *
  * Parameters:
- *  line        - A pointer to the line being checked.
- *  label_name  - A pointer to the variable where the label name will be stored.
- *  line_number - The line number of the label for error reporting.
+ *  line        - The tokens of the line being checked.
+ *  label       - A pointer to the variable where the interned name of the label will be stored.
  *
  * Returns:
  *  1 if the line contains a valid label, 0 otherwise.
  */
-int is_label(char **line, char **label_name, int line_number);
+int is_label(token_cursor *line, unsigned int *label);
+
+/*
+ * Function: parse_data_number
+ * ---------------------------
+ * Parses a number token of a .data list, four digits at a time, and checks
+ * that it fits in a data word.
+ *
+ * Parameters:
+ *  text   - The characters of the token: an optional sign and decimal digits.
+ *  length - The number of characters in the token.
+ *  value  - A pointer to where the value will be stored.
+ *
+ * Returns:
+ *  1 if the value is between DATA_MIN and DATA_MAX, 0 otherwise.
+ */
+int parse_data_number(const char *text, size_t length, long *value);
 
 #endif /*UTILITY_H*/
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "assembler.h"
+#include "preprocessor.h"
+#include "first_pass.h"
+#include "second_pass.h"
+#include "token_file.h"
+#include "object_file.h"
+
+/*
+ * Purpose:
+ * This file implements the assembler context and the driver that runs the
+ * assembler's phases on it. The context is bound to the thread that assembles
+ * it, so that `safe_alloc` and `report` deep inside the phases use the context's
+ * arena and message buffer without every function having to pass it along.
+ *
+ * Key Functions:
+ * - `init_assembler_ctx`: Prepares a context for a file.
+ * - `bind_assembler_ctx`: Binds the context's arena and messages to the thread.
+ * - `assemble`: Assembles a source file into the output files.
+ * - `assemble_source`: Assembles source text from memory into `ctx->result`.
+ * - `release_assembler_ctx`: Releases the context's memory in one step.
+ */
+
+/**
+ * Function: init_assembler_ctx
+ * Purpose: Prepares a context for assembling a file.
+ *
+ * Parameters:
+ *   - ctx: The context to initialise.
+ *   - file_name: The base name of the source file.
+ *   - emit_am: Whether to also write the .am file.
+ *   - buffer_messages: Whether to collect messages instead of printing them.
+ */
+void init_assembler_ctx(assembler_ctx *ctx, const char *file_name, const int emit_am,
+                        const int buffer_messages) {
+  ctx->file_name = file_name;
+  ctx->emit_am = emit_am;
+  ctx->use_token_file = 0;
+  ctx->token_file = NULL;
+  ctx->token_file_size = 0;
+  ctx->object_files = TEXT_OBJECT_FILES;
+  ctx->remove_stale = 0;
+  ctx->arena.current = NULL;
+  ctx->arena.last = NULL;
+  ctx->arena.on_failure = &ctx->on_failure;
+  ctx->messages.text = NULL;
+  ctx->messages.length = 0;
+  ctx->messages.capacity = 0;
+  ctx->buffer_messages = buffer_messages;
+  ctx->macros = NULL;
+  ctx->label_table = NULL;
+  ctx->entry_table = NULL;
+  ctx->intern_table = NULL;
+  ctx->IC = START_ADDRESS;
+  ctx->DC = 0;
+  ctx->status = NORMAL;
+  ctx->result.words = NULL;
+  ctx->result.code_size = 0;
+  ctx->result.data_size = 0;
+  ctx->result.entries = NULL;
+  ctx->result.entry_count = 0;
+  ctx->result.externals = NULL;
+  ctx->result.extern_count = 0;
+  ctx->result.relocations = NULL;
+  ctx->result.relocation_count = 0;
+}
+
+/**
+ * Function: bind_assembler_ctx
+ * Purpose: Routes the calling thread's allocations and messages through a context.
+ *
+ * Parameters:
+ *   - ctx: The context to bind, or NULL to restore the defaults.
+ */
+void bind_assembler_ctx(assembler_ctx *ctx) {
+  if (ctx == NULL) {
+    bind_arena(NULL);
+    bind_diagnostics(NULL);
+    return;
+  }
+  bind_arena(&ctx->arena);
+  bind_diagnostics(ctx->buffer_messages ? &ctx->messages : NULL);
+}
+
+/**
+ * Function: translate
+ * Purpose: Runs the first and second pass on the preprocessed source, leaving the
+ * object words, entries and externals in `ctx->result`.
+ *
+ * Parameters:
+ *   - ctx: The bound context, after preprocessing.
+ *
+ * Returns:
+ *   - NORMAL if the source was assembled, ERROR otherwise.
+ */
+static enum errors translate(assembler_ctx *ctx) {
+  if (first_pass(ctx) != NORMAL) {
+    return ERROR;
+  }
+  return second_pass(ctx);
+}
+
+/**
+ * Function: run_file_phases
+ * Purpose: Assembles the context's source file and writes the output files,
+ * stopping at the first failure.
+ *
+ * An allocation failure anywhere in the phases unwinds back here through the
+ * arena's recovery point and fails the assembly.
+ *
+ * Parameters:
+ *   - ctx: The bound context to assemble.
+ *
+ * Returns:
+ *   - NORMAL if every phase succeeded, ERROR otherwise.
+ */
+static enum errors run_file_phases(assembler_ctx *ctx) {
+  if (setjmp(ctx->on_failure) != 0) {
+    return ERROR; /* out of memory */
+  }
+  report("processing %s\n", ctx->file_name);
+  if (preprocess(ctx) != NORMAL || translate(ctx) != NORMAL) {
+    return ERROR;
+  }
+  if ((ctx->object_files & TEXT_OBJECT_FILES) &&
+      (create_extern_file(ctx) != NORMAL || create_entry_file(ctx) != NORMAL ||
+       create_ob_file(ctx) != NORMAL)) {
+    return ERROR;
+  }
+  if ((ctx->object_files & BINARY_OBJECT_FILE) && create_binary_object_file(ctx) != NORMAL) {
+    return ERROR;
+  }
+  return NORMAL;
+}
+
+/**
+ * Function: run_source_phases
+ * Purpose: Assembles source text held in memory into `ctx->result`.
+ *
+ * Parameters:
+ *   - ctx: The bound context to assemble.
+ *   - source: The source text.
+ *   - length: The number of characters in the source.
+ *
+ * Returns:
+ *   - NORMAL if the source was assembled, ERROR otherwise.
+ */
+static enum errors run_source_phases(assembler_ctx *ctx, const char *source,
+                                     const size_t length) {
+  if (setjmp(ctx->on_failure) != 0) {
+    return ERROR; /* out of memory */
+  }
+  if (preprocess_text(ctx, source, length) != NORMAL) {
+    return ERROR;
+  }
+  return translate(ctx);
+}
+
+/**
+ * Function: assemble
+ * Purpose: Assembles the context's file with the context bound to the calling thread.
+ *
+ * Parameters:
+ *   - ctx: The context to assemble.
+ *
+ * Returns:
+ *   - NORMAL if the output files were written, ERROR otherwise.
+ */
+enum errors assemble(assembler_ctx *ctx) {
+  bind_assembler_ctx(ctx);
+  ctx->status = run_file_phases(ctx);
+  bind_assembler_ctx(NULL);
+  return ctx->status;
+}
+
+/**
+ * Function: assemble_source
+ * Purpose: Assembles source text from memory with the context bound to the calling thread.
+ *
+ * Parameters:
+ *   - ctx: The context to assemble.
+ *   - source: The source text.
+ *   - length: The number of characters in the source.
+ *
+ * Returns:
+ *   - NORMAL if the source was assembled, ERROR otherwise.
+ */
+enum errors assemble_source(assembler_ctx *ctx, const char *source, const size_t length) {
+  bind_assembler_ctx(ctx);
+  ctx->status = run_source_phases(ctx, source, length);
+  bind_assembler_ctx(NULL);
+  return ctx->status;
+}
+
+/**
+ * Function: release_assembler_ctx
+ * Purpose: Releases every block allocated for the context, including its result,
+ * and unmaps its .amt file, keeping its messages.
+ *
+ * Parameters:
+ *   - ctx: The context to release.
+ */
+void release_assembler_ctx(assembler_ctx *ctx) {
+  arena_release(&ctx->arena);
+  close_token_file(ctx);
+  ctx->macros = NULL;
+  ctx->label_table = NULL;
+  ctx->entry_table = NULL;
+  ctx->intern_table = NULL;
+  ctx->result.words = NULL;
+  ctx->result.entries = NULL;
+  ctx->result.externals = NULL;
+  ctx->result.relocations = NULL;
+}
@@ -12,7 +12,7 @@
 #include <string.h>
 
 /* Default structure representing a non-existent operation */
-static const operation_syntax no_operation = {NULL, -1, -1, {0, 0, 0, 0}, {0, 0, 0, 0}};
+const operation_syntax no_operation = {NULL, -1, -1, {0, 0, 0, 0}, {0, 0, 0, 0}};
 
 /*
  * Array of valid operations with their corresponding opcodes and addressing modes.
@@ -42,28 +42,89 @@ static const operation_syntax operations[] = {
     {"stop", 15, 0, {0, 0, 0, 0}, {0, 0, 0, 0}}
 };
 
+/* Short names for the character classes, to keep the table below one row per 16 bytes */
+#define SP CHAR_SPACE
+#define LT (CHAR_LETTER | CHAR_LABEL_START | CHAR_LABEL)
+#define US (CHAR_LABEL_START | CHAR_LABEL)
+#define DG (CHAR_DIGIT | CHAR_LABEL)
+#define SG CHAR_SIGN
+#define SE CHAR_SEPARATOR
+#define CM CHAR_COMMENT
+
+/* The class of each byte value; the comment of a row gives its first character */
+const unsigned char char_classes[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, SP, SP, SP, SP, SP, 0, 0,       /* 0x00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,            /* 0x10 */
+    SP, 0, 0, SE, 0, 0, SE, 0, 0, 0, 0, SG, SE, SG, SE, 0,     /* ' ' */
+    DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, SE, CM, 0, 0, 0, 0, /* '0' */
+    0, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, /* '@' */
+    LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, 0, 0, 0, 0, US, /* 'P' */
+    0, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, /* '`' */
+    LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, 0, 0, 0, 0, 0  /* 'p' */
+    /* 0x80 to 0xff: no class */
+};
+
+#undef SP
+#undef LT
+#undef US
+#undef DG
+#undef SG
+#undef SE
+#undef CM
+
 /* Number of defined operations */
 const int num_of_operations = sizeof(operations) / sizeof(operation_syntax);
 
+/*
+ * Perfect hash over the mnemonics: OPERATION_HASH maps each of the 16 mnemonics
+ * to a different slot of operation_slots, which holds the index of the operation
+ * in operations[] (or -1 for an unused slot). The hash only looks at the first
+ * three characters, so a lookup is a few arithmetic instructions followed by a
+ * single comparison against the one candidate.
+ * The multipliers were found by searching for the smallest collision-free table;
+ * they must be searched again if a mnemonic is added.
+ */
+#define OPERATION_SLOTS 32
+#define OPERATION_HASH(name)                                                   \
+  (((unsigned char)(name)[0] + (unsigned char)(name)[1] +                      \
+    10 * (unsigned char)(name)[2]) & (OPERATION_SLOTS - 1))
+
+static const signed char operation_slots[OPERATION_SLOTS] = {
+    -1, -1, 10, 5, 14, 6, -1, 8,     /* -, -, bne, clr, rts, not, -, dec */
+    -1, -1, -1, -1, -1, 2, 13, -1,   /* -, -, -, -, -, add, prn, - */
+    1, 11, -1, -1, -1, 7, -1, 9,     /* cmp, jsr, -, -, -, inc, -, jmp */
+    0, -1, -1, 4, 3, 15, -1, 12      /* mov, -, -, lea, sub, stop, -, red */
+};
+
 /*
  * Function: find_operation
  * -------------------------
- * Searches for an operation by its name and returns its corresponding structure.
+ * Searches for an operation by its name with a single perfect-hash probe.
+ * Nothing is reported when the name is not an operation; the caller decides
+ * whether that is an error.
  *
  * Parameters:
- *   - name: The name of the operation to search for.
+ *   - name: The name of the operation to search for (need not be '\0'-terminated).
+ *   - length: The number of characters in the name.
  *
  * Returns:
- *   - The corresponding operation_syntax structure if found.
- *   - A default "no_operation" structure if not found, triggering an error.
+ *   - A pointer to the corresponding entry of the operation table if found.
+ *   - NULL if not found.
  */
-operation_syntax find_operation(char *name) {
-    int i;
-    for (i = 0; i < num_of_operations; i++) {
-        if (strcmp(operations[i].name, name) == 0) {
-            return operations[i];
-        }
+const operation_syntax *find_operation(const char *name, const size_t length) {
+    const operation_syntax *candidate;
+    int index;
+
+    if (length < MIN_OPERATION_NAME_LEN || length > MAX_OPERATION_NAME_LEN) {
+        return NULL;
+    }
+    index = operation_slots[OPERATION_HASH(name)];
+    if (index < 0) {
+        return NULL;
+    }
+    candidate = &operations[index];
+    if (strncmp(candidate->name, name, length) != 0 || candidate->name[length] != '\0') {
+        return NULL;
     }
-    NON_EXISTANT_NAME(name);  /* Trigger an error for a non-existent operation */
-    return no_operation;       /* Return the default no-operation structure */
-}
\ No newline at end of file
+    return candidate;
+}
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200112L /* for pthread keys and vsnprintf */
+#include "diagnostics.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Purpose:
+ * This file implements the destination of the assembler's messages. Each thread
+ * may bind its own diagnostics buffer through a thread-specific key; threads that
+ * never bind one (including the main thread in sequential mode) print directly.
+ *
+ * Key Functions:
+ * - `report`: Formats a message into the bound buffer or prints it.
+ * - `bind_diagnostics`: Binds a buffer to the calling thread.
+ * - `flush_diagnostics`: Prints and empties a buffer.
+ * - `free_diagnostics`: Releases a buffer.
+ */
+
+static pthread_key_t diagnostics_key;
+static pthread_once_t diagnostics_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Title: Create Diagnostics Key
+ *
+ * Purpose:
+ * Creates the thread-specific key holding each thread's bound buffer. Run once.
+ */
+static void create_diagnostics_key(void) {
+  pthread_key_create(&diagnostics_key, NULL);
+}
+
+/**
+ * Title: Reserve Diagnostics Space
+ *
+ * Purpose:
+ * Makes sure the buffer has room for `extra` more characters plus a terminator.
+ *
+ * @param buffer The buffer to grow.
+ * @param extra The number of characters about to be appended.
+ * @return int 1 on success, 0 if memory could not be allocated.
+ */
+static int reserve(diagnostics *buffer, const size_t extra) {
+  size_t new_capacity;
+  char *new_text;
+  if (buffer->length + extra + 1 <= buffer->capacity) {
+    return 1;
+  }
+  new_capacity = buffer->capacity == 0 ? DIAGNOSTIC_LINE_SIZE : buffer->capacity;
+  while (buffer->length + extra + 1 > new_capacity) {
+    new_capacity *= 2;
+  }
+  new_text = realloc(buffer->text, new_capacity);
+  if (new_text == NULL) {
+    return 0;
+  }
+  buffer->text = new_text;
+  buffer->capacity = new_capacity;
+  return 1;
+}
+
+/**
+ * Title: Report Message
+ *
+ * Purpose:
+ * Formats a message like printf and sends it to the calling thread's buffer, or to
+ * stdout when no buffer is bound (or the buffer cannot grow).
+ *
+ * @param format The printf format string, followed by its arguments.
+ * @return int The number of characters in the message.
+ */
+int report(const char *format, ...) {
+  diagnostics *buffer;
+  va_list args;
+  int length;
+
+  pthread_once(&diagnostics_key_once, create_diagnostics_key);
+  buffer = pthread_getspecific(diagnostics_key);
+
+  va_start(args, format);
+  if (buffer == NULL || !reserve(buffer, DIAGNOSTIC_LINE_SIZE)) {
+    length = vprintf(format, args);
+    va_end(args);
+    return length;
+  }
+  length = vsnprintf(buffer->text + buffer->length, buffer->capacity - buffer->length,
+                     format, args);
+  va_end(args);
+  if (length >= 0 && (size_t) length >= buffer->capacity - buffer->length) {
+    /* The message did not fit: grow the buffer and format it again. */
+    if (!reserve(buffer, (size_t) length)) {
+      return length;
+    }
+    va_start(args, format);
+    vsnprintf(buffer->text + buffer->length, buffer->capacity - buffer->length, format, args);
+    va_end(args);
+  }
+  if (length > 0) {
+    buffer->length += (size_t) length;
+  }
+  return length;
+}
+
+/**
+ * Title: Bind Diagnostics
+ *
+ * Purpose:
+ * Sends the calling thread's messages to `buffer`, or back to stdout if it is NULL.
+ *
+ * @param buffer The buffer to bind, or NULL.
+ */
+void bind_diagnostics(diagnostics *buffer) {
+  pthread_once(&diagnostics_key_once, create_diagnostics_key);
+  pthread_setspecific(diagnostics_key, buffer);
+}
+
+/**
+ * Title: Flush Diagnostics
+ *
+ * Purpose:
+ * Prints the collected messages to stdout with a single write and empties the buffer.
+ *
+ * @param buffer The buffer to print.
+ */
+void flush_diagnostics(diagnostics *buffer) {
+  if (buffer->length > 0) {
+    fwrite(buffer->text, 1, buffer->length, stdout);
+  }
+  buffer->length = 0;
+}
+
+/**
+ * Title: Free Diagnostics
+ *
+ * Purpose:
+ * Releases the memory held by a buffer, leaving a valid empty buffer.
+ *
+ * @param buffer The buffer to release.
+ */
+void free_diagnostics(diagnostics *buffer) {
+  free(buffer->text);
+  buffer->text = NULL;
+  buffer->length = buffer->capacity = 0;
+}
@@ -10,60 +10,98 @@
 #include "utility.h"
 #include "handle_text.h"
 #include "mem_image.h"
-#include "second_pass.h"
 #include "tables.h"
 #include "memory_utility.h"
-#include <ctype.h>
 
 /*
- * Function: check_label_conflicts
- * Purpose: Checks if a label already exists in the label table and handles conflicts.
+ * Function: define_label
+ * Purpose: Adds a label to the label table, reporting a conflict if it already exists.
  *
  * Parameters:
  *   status - Pointer to the current status of the assembler (for error handling).
- *   table - Pointer to the label table.
- *   label_name - The label name to check for conflicts.
- *   line_number - The line number where the conflict is found.
+ *   label_table - Pointer to the label table.
+ *   label - The interned name of the label to define.
+ *   value - The value (address) of the label.
+ *   type - The type of the label (DATA or CODE).
+ *   line_number - The line number where the label is defined.
  *
  * Side Effects:
  *   - Sets the status to ERROR if a conflict is found.
  */
-void check_label_conflicts(enum errors *status, label_table_head *label_table,
-                           char *label_name, const int line_number) {
-  if (find_label(label_name, *label_table) != NULL) {
-    CONFLICTING_LABELS(line_number, label_name);
+void define_label(enum errors *status, label_table_head *label_table,
+                  unsigned int label, int value, label_data_type type,
+                  const int line_number) {
+  if (!add_label(label_table, label, value, type, DEFAULT)) {
+    CONFLICTING_LABELS(line_number, symbol_name(label_table->symbols, label));
     *status = ERROR;
   }
 }
 
 /*
  * Function: write_str
- * Purpose: Writes a string to the data image.
+ * Purpose: Writes a string to the data image, followed by a zero word.
  *
  * Parameters:
  *   data_image - The memory image for data storage.
  *   DC - The current data counter.
- *   str - The string to write.
+ *   str - The characters to write.
+ *   length - The number of characters.
  */
-void write_str(memory data_image, int DC, char *str) {
-  int i = 0;
-  while (*str != '\0') {
-    data_image[DC + i].data.value = 0; /* Zero out noise */
-    data_image[DC + i].character.value = *str;
-    i++;
-    str++;
+void write_str(memory *data_image, int DC, const char *str, size_t length) {
+  size_t i;
+  memory_word *word;
+  for (i = 0; i < length; i++) {
+    word = image_word(data_image, DC + (int)i);
+    word->data.value = 0; /* Zero out noise */
+    word->character.value = str[i];
   }
-  data_image[DC + i].data.value = 0;
+  image_word(data_image, DC + (int)i)->data.value = 0;
+}
+
+/*
+ * Function: label_operand_symbol
+ * Purpose: Returns the interned name of a label operand.
+ *
+ * The label is the run of tokens starting at `first` that are not separated by
+ * whitespace, up to `end`. A label made of a single identifier already has an
+ * interned name; anything else is interned here, so that it can be reported
+ * as an undefined label like any other.
+ *
+ * Parameters:
+ *   line - The tokens of the line holding the operand.
+ *   first - The index of the first token of the label.
+ *   end - The index of the first token after the operand.
+ *
+ * Returns:
+ *   - The interned name of the label ("" if the operand has no label).
+ */
+static unsigned int label_operand_symbol(token_cursor *line, int first, int end) {
+  const token *start, *last;
+  int last_index;
+  if (first >= end) {
+    return intern(line->symbols, "", 0);
+  }
+  last_index = run_end(line, first);
+  last_index = (last_index < end ? last_index : end) - 1;
+  start = &line->tokens[first];
+  last = &line->tokens[last_index];
+  if (first == last_index && start->kind == TOKEN_IDENTIFIER) {
+    return start->symbol;
+  }
+  return intern(line->symbols, line->text + start->offset,
+                last->offset + last->length - start->offset);
 }
 
 /*
  * Function: extract_operand
- * Purpose: Extracts an operand from a given string and stores it in the temporary memory word.
+ * Purpose: Extracts an operand from a range of tokens and stores it in the temporary memory word.
  *
  * Parameters:
- *   operand - The operand string to extract.
+ *   line - The tokens of the line holding the operand.
+ *   first - The index of the first token of the operand.
+ *   end - The index of the first token after the operand.
  *   temp - The temporary memory word array to store the extracted operand.
- *   operand_label - The label associated with the operand (if any).
+ *   operand_label - The interned label of the operand, NO_SYMBOL if it has none.
  *   operand_number - The operand number (0 or 1).
  *   type - The operand type (source or destination).
  *   relative - A flag indicating if the operand is relative.
@@ -71,16 +109,17 @@ void write_str(memory data_image, int DC, char *str) {
  * Returns:
  *   - The number of operands extracted (1 or 0).
  */
-int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN], char **operand_label, int operand_number, enum op_type type,int *relative) {
-  char *endptr;
-  char *label;
-  int i;
+int extract_operand(token_cursor *line, int first, int end, memory_word temp[MAX_OPERATION_LEN],
+                    unsigned int *operand_label, int operand_number, enum op_type type, int *relative) {
+  const token *operand = first < end ? &line->tokens[first] : NULL;
+  const token *value;
   *relative = 0;
-  if (*operand == IMMEDIATE_PARAM_INDICATOR) {
-    operand++;
-    *operand_label = NULL;
+  if (operand != NULL && operand->kind == TOKEN_HASH) {
+    value = first + 1 < end ? &line->tokens[first + 1] : NULL;
+    *operand_label = NO_SYMBOL;
     temp[operand_number].data.value = 0;
-    temp[operand_number].operand.value = strtol(operand, &endptr, 10);
+    temp[operand_number].operand.value =
+        value != NULL && value->kind == TOKEN_NUMBER ? strtol(line->text + value->offset, NULL, 10) : 0;
     temp[operand_number].operand.A = 1;
     if (type == DEST) {
       temp->operation.dest_type = IMMEDIATE;
@@ -89,26 +128,25 @@ int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN], char **o
       temp->operation.source_type = IMMEDIATE;
       temp->operation.source_reg = 0;
     }
-    if (endptr == operand || !is_whitespace(endptr)) {
-      MISSING_OPERAND(*operand);
+    if (value == NULL || value->kind != TOKEN_NUMBER || first + 2 < end) {
+      MISSING_OPERAND(value != NULL && value->offset == operand->offset + 1 ? line->text[value->offset] : '\0');
       /* todo throw error*/
     }
-    *operand_label = NULL;
     return 1;
   }
-  if (is_register(operand)) {
-    *operand_label = NULL;
+  if (operand != NULL && is_register(line, first, end)) {
+    *operand_label = NO_SYMBOL;
     if (type == DEST) {
-      temp->operation.dest_reg = *(operand + 1) - '0';
+      temp->operation.dest_reg = line->text[operand->offset + 1] - '0';
       temp->operation.dest_type = REGISTER;
     } else if (type == SOURCE) {
-      temp->operation.source_reg = *(operand + 1) - '0';
+      temp->operation.source_reg = line->text[operand->offset + 1] - '0';
       temp->operation.source_type = REGISTER;
     }
     return 0;
   }
   /* label operand */
-  if (*operand == RELATIVE_INDICATOR) {
+  if (operand != NULL && operand->kind == TOKEN_AMPERSAND) {
     *relative = 1;
     if (type == DEST) {
       temp->operation.dest_type = RELATIVE;
@@ -117,19 +155,13 @@ int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN], char **o
       temp->operation.source_type = RELATIVE;
       temp->operation.source_reg = 0;
     }
-    operand++;
-  }
-  label = safe_alloc(strlen(operand) + 1);
-
-  for (i = 0; 1; operand++) {
-    if (isspace(*operand) || *operand == '\0') {
-      label[i] = '\0';
-      break;
+    /* the label must be glued to the indicator */
+    first++;
+    if (first < end && line->tokens[first].offset != operand->offset + 1) {
+      end = first;
     }
-    label[i] = *operand;
-    i++;
   }
-  *operand_label = label;
+  *operand_label = label_operand_symbol(line, first, end);
   if (*relative == 0 && type == DEST) {
     temp->operation.dest_type = DIRECT;
     temp->operation.dest_reg = 0;
@@ -140,78 +172,81 @@ int extract_operand(char *operand, memory_word temp[MAX_OPERATION_LEN], char **o
   return 1;
 }
 
-void check_macro_conflicts(enum errors * errors, struct Macro_table * macro_table, char * intern_name,
+void check_macro_conflicts(enum errors * errors, struct Macro_table * macro_table, unsigned int label,
                           int line_number) {
-  if (is_saved_macro(intern_name, macro_table) != -1) {
-    LABEL_MACRO_CONFLICT(line_number, intern_name);
+  if (find_macro(macro_table, label) != NULL) {
+    LABEL_MACRO_CONFLICT(line_number, symbol_name(macro_table->symbols, label));
     *errors = ERROR;
   }
 }
 
 /**
  * Function: first_pass
- * Purpose: Performs the first pass of the assembler by reading the input file and
+ * Purpose: Performs the first pass of the assembler by reading the expanded source and
  * processing each line.
  *
  * Parameters:
- *   file_name - The name of the input file to assemble.
+ *   ctx - The assembler context holding the macro table and expanded source produced by
+ *         the preprocessor. The tables, images and final counters are stored in it.
+ *
+ * Returns:
+ *   - NORMAL if the source has no errors, ERROR otherwise.
  */
-void first_pass(const char *file_name, struct Macro_table *macro_table) {
-  char *line, *work_line, *intern_name;
+enum errors first_pass(assembler_ctx *ctx) {
+  unsigned int label;
+  token_cursor line;
+  int i;
   inst instruction_type;
   int label_flag;
-  int IC = 100, DC = 0;
-  char *input_file = add_extension(file_name, ASSEMBLER_INPUT_EXT);
+  int IC = START_ADDRESS, DC = 0;
   enum errors status = NORMAL;
   int line_number = 0;
-
-
-  /*these need to get to the second pass*/
-  memory data_image;
-  memory code_image;
-  label_table_head *label_table = initialise_label_table();
+  label_table_head *label_table;
   entry_table_head *entry_table = initialise_entry_table();
   intern_table_head *intern_table = initialise_intern_table();
-  /*up to here need to get to the second pass*/
 
-  FILE *input = fopen(input_file, "r"); /*open input file in 'read' mode*/
-  if (input == NULL) {
-    FILE_OPEN_ERROR();
-    free_all_memory();
-    exit(EXIT_FAILURE);
-  }
-  while ((work_line = line = getLine(input)) != NULL) {
+  /*presize the images from the length of the input; they grow as needed*/
+  init_memory_image(&ctx->code_image, START_ADDRESS + ctx->expanded.length / SOURCE_BYTES_PER_WORD);
+  init_memory_image(&ctx->data_image, ctx->expanded.length / SOURCE_BYTES_PER_WORD);
+  /*the label table has a slot for every identifier of the source*/
+  label_table = initialise_label_table(&ctx->symbols);
+  /*read the expanded source through the tokens the preprocessor made of it*/
+  for (i = 0; i < ctx->tokens.line_count; i++) {
+    open_token_cursor(&line, &ctx->tokens, i, ctx->expanded.text, &ctx->symbols);
     label_flag = 0;
     line_number++;
-    if (is_whitespace(line) || is_comment(line)) {
+    if (is_whitespace(&line) || is_comment(&line)) {
       continue;
     }
-    if (is_label(&work_line, &intern_name, line_number)) {
+    if (is_label(&line, &label)) {
       label_flag = 1;
-      check_label_conflicts(&status, label_table, intern_name, line_number);
-      check_macro_conflicts(&status, macro_table, intern_name, line_number);
+      check_macro_conflicts(&status, ctx->macros, label, line_number);
     }
-    if (is_instruction(&work_line, &instruction_type, line_number)) {
+    if (is_instruction(&line, &instruction_type, line_number)) {
       if (instruction_type == INVALID_INST) {
         continue;
       }
-      handle_instruction(&DC, &data_image, &status, label_table, entry_table, work_line,
-                         &intern_name, instruction_type, line_number,
+      handle_instruction(&DC, &ctx->data_image, &status, label_table, entry_table, &line,
+                         &label, instruction_type, line_number,
                          label_flag);
       continue;
     }
-    /*the line is an operation line, work_line is pointing to the start of the
-     * operation or to a whitespace before it*/
+    /*the line is an operation line, the cursor is at the operation name*/
     if (label_flag) {
-      add_label(label_table, intern_name, IC, CODE, DEFAULT);
+      define_label(&status, label_table, label, IC, CODE, line_number);
+      /*backpatch the references that were waiting for the label*/
+      resolve_references(intern_table, find_label(label, *label_table), &ctx->code_image);
     }
-    IC += handle_operation(&work_line, &status, intern_table, line_number, code_image,
-                           IC);
-    free_ptr(line);
-  }
-  if (status == NORMAL) {
-    populate_labels(file_name, code_image, *label_table, *intern_table, IC);
-    create_entry_file(file_name, *label_table, *entry_table, IC);
-    create_ob_file(file_name, code_image, data_image, IC, DC);
+    IC += handle_operation(&line, &status, label_table, intern_table, line_number,
+                           &ctx->code_image, IC);
   }
-}
\ No newline at end of file
+
+  /*hand everything the second pass needs over to the context*/
+  ctx->label_table = label_table;
+  ctx->entry_table = entry_table;
+  ctx->intern_table = intern_table;
+  ctx->IC = IC;
+  ctx->DC = DC;
+  ctx->status = status;
+  return status;
+}
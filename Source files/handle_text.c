@@ -1,5 +1,4 @@
 #include "const_tables.h"
-#include <ctype.h>
 #include "first_pass.h"
 #include "parsing.h"
 #include "const_tables.h"
@@ -11,10 +10,11 @@
 /*
  * Function: handle_numbers
  * Purpose: Parses numbers from a line, handling the parsing and storing them in
- * the data image.
+ * the data image. Each number is converted by parse_data_number; one that does
+ * not fit in a data word is an error and stored as 0.
  *
  * Parameters:
- *   line - The line of text containing the numbers.
+ *   line - The tokens of the line, positioned after the directive.
  *   line_number - The line number in the source file.
  *   status - Pointer to the assembler's current status (for error handling).
  *   data_image - The memory image for data storage.
@@ -23,26 +23,31 @@
  * Returns:
  *   - The number of numbers parsed from the line.
  */
-int handle_numbers(char *line, int line_number, enum errors *status,
-                   memory data_image, int DC) {
-    int i, num;
-    char *end_ptr, *work_line = line;
+int handle_numbers(token_cursor *line, int line_number, enum errors *status,
+                   memory *data_image, int DC) {
+    int i;
+    long num;
+    const token *next;
     for (i = 1; 1; i++) {
-        num = strtol(work_line, &end_ptr, 10);
-        if (end_ptr == work_line) {
-            MISSING_NUMBER_OR_EXTRA_COMMA(line_number);
+        next = peek_token(line);
+        if (next != NULL && next->kind == TOKEN_NUMBER) {
+            if (!parse_data_number(line->text + next->offset, next->length, &num)) {
+                num = 0;
+                DATA_OUT_OF_RANGE(line_number);
+                *status = ERROR;
+            }
+            line->position++;
         } else {
-            work_line = end_ptr;
-        }
-        while (isspace(*work_line)) {
-            work_line++;
+            num = 0;
+            MISSING_NUMBER_OR_EXTRA_COMMA(line_number);
         }
-        if (*work_line == ',') {
-            data_image[DC].data.value = num;
+        next = peek_token(line);
+        if (next != NULL && next->kind == TOKEN_COMMA) {
+            image_word(data_image, DC)->data.value = num;
             DC++;
-            work_line++;
-        } else if (*work_line == '\0' || is_whitespace(work_line)) {
-            data_image[DC].data.value = num;
+            line->position++;
+        } else if (next == NULL) {
+            image_word(data_image, DC)->data.value = num;
             return i;
         } else {
             MISSING_COMMA(line_number);
@@ -60,21 +65,24 @@ int handle_numbers(char *line, int line_number, enum errors *status,
  *   DC - Pointer to the current data counter.
  *   data_image - The memory image for data storage.
  *   status - Pointer to the assembler's current status (for error handling).
- *   work_line - The line of text containing the data instruction.
+ *   line - The tokens of the line, positioned after the directive.
  *   instruction_type - The type of data instruction (DATA_INST or STRING_INST).
  *   line_number - The current line number.
  */
-void handle_data_instruction(int *DC, memory data_image, enum errors *status,
-                             char *work_line, inst instruction_type,
+void handle_data_instruction(int *DC, memory *data_image, enum errors *status,
+                             token_cursor *line, inst instruction_type,
                              int line_number) {
   if (instruction_type == DATA_INST) {
     int num_count =
-        handle_numbers(work_line, line_number, status, data_image, *DC);
+        handle_numbers(line, line_number, status, data_image, *DC);
     *DC += num_count;
   } else if (instruction_type == STRING_INST) {
-    char *str = parse_string(work_line, line_number, status);
-    write_str(data_image, *DC, str);
-    *DC += (int)strlen(str) + 1;
+    size_t length;
+    const char *str = parse_string(line, &length, line_number, status);
+    if (str != NULL) {
+      write_str(data_image, *DC, str, length);
+      *DC += (int)length + 1;
+    }
   }
 }
 
@@ -87,33 +95,37 @@ void handle_data_instruction(int *DC, memory data_image, enum errors *status,
  *   data_image - The memory image for data storage.
  *   status - Pointer to the assembler's current status (for error handling).
  *   table - Pointer to the label table.
- *   work_line - The line containing the instruction to handle.
- *   label_name - Pointer to the label name (if present).
+ *   line - The tokens of the line, positioned after the directive.
+ *   label - Pointer to the interned label name (if present).
  *   instruction_type - The type of instruction.
  *   line_number - The current line number.
  *   label_flag - Indicates whether a label is present.
  */
 void handle_instruction(int *DC, memory *data_image, enum errors *status,
-                        label_table_head *label_table, entry_table_head *entry_table, char *work_line, char **label_name,
+                        label_table_head *label_table, entry_table_head *entry_table, token_cursor *line, unsigned int *label,
                         inst instruction_type, int line_number,
                         int label_flag) {
   if (is_data_instruction(instruction_type)) {
     if (label_flag) {
-      add_label(label_table, *label_name, *DC, DATA, DEFAULT);
+      define_label(status, label_table, *label, *DC, DATA, line_number);
     }
-    handle_data_instruction(DC, *data_image, status, work_line,
+    handle_data_instruction(DC, data_image, status, line,
                             instruction_type, line_number);
   } else if (is_linking_instruction(instruction_type)) {
     if (label_flag) {
       LABELED_LINKING_WARNING(line_number);
     }
-    if (instruction_type == EXTERN_INST) {
-      *label_name = parse_linking_instruction(work_line, line_number, status);
-      add_label(label_table, *label_name, DEFAULT_EXTERN_VALUE, EXTERNAL, EXTERN);
+    *label = parse_linking_instruction(line, line_number, status);
+    if (*label == NO_SYMBOL) {
+      return;
+    }
+    if (instruction_type == EXTERN_INST &&
+        !add_label(label_table, *label, DEFAULT_EXTERN_VALUE, EXTERNAL, EXTERN)) {
+      CONFLICTING_LABELS(line_number, symbol_name(label_table->symbols, *label));
+      *status = ERROR;
     }
     if (instruction_type == ENTRY_INST) {
-      *label_name = parse_linking_instruction(work_line, line_number, status);
-      add_new_entry(entry_table, *label_name);
+      add_new_entry(entry_table, *label);
     }
   }
 }
@@ -124,9 +136,9 @@ void handle_instruction(int *DC, memory *data_image, enum errors *status,
  *
  * Parameters:
  *   temp - The memory word to store the operation.
- *   source_label - The source operand label (if present).
- *   dest_label - The destination operand label (if present).
- *   line - The line of text containing the operation.
+ *   source_label - The interned source operand label (if present).
+ *   dest_label - The interned destination operand label (if present).
+ *   line - The tokens of the line, positioned after the operation name.
  *   syntax - The syntax structure for the operation.
  *   value1 - A pointer to an integer to store the value.
  *
@@ -134,12 +146,12 @@ void handle_instruction(int *DC, memory *data_image, enum errors *status,
  *   - 1 if the operation was handled successfully.
  *   - 0 if there was an error.
  */
-int handle_no_operand_operation(memory_word *temp, char **source_label,
-                                 char **dest_label, char *line,
+int handle_no_operand_operation(memory_word *temp, unsigned int *source_label,
+                                 unsigned int *dest_label, const token_cursor *line,
                                  operation_syntax syntax, int *value1) {
     if (is_whitespace(line)) {
-        *source_label = NULL;
-        *dest_label = NULL;
+        *source_label = NO_SYMBOL;
+        *dest_label = NO_SYMBOL;
         temp->data.value = 0;
         temp->operation.opcode = syntax.opcode;
         temp->operation.A = 1;
@@ -155,9 +167,13 @@ int handle_no_operand_operation(memory_word *temp, char **source_label,
  * Function: handle_operation
  * Purpose: Handles the parsing and processing of an operation line in the assembly code.
  *
+ * The words are copied into the code image before the label operands are
+ * resolved, so a reference to a label that is already defined is patched in place.
+ *
  * Parameters:
- *   work_line - The line containing the operation to parse.
+ *   line - The tokens of the line, positioned at the operation.
  *   status - Pointer to the current status of the assembler.
+ *   label_table - Pointer to the label table.
  *   table - Pointer to the intern table.
  *   line_number - The current line number.
  *   code_image - The memory image for the code.
@@ -166,36 +182,36 @@ int handle_no_operand_operation(memory_word *temp, char **source_label,
  * Returns:
  *   - The size of the operation parsed.
  */
-int handle_operation(char **work_line, enum errors *status,
+int handle_operation(token_cursor *line, enum errors *status, label_table_head *label_table,
                      intern_table_head *table, int line_number,
-                     memory code_image, const int IC) {
+                     memory *code_image, const int IC) {
     int i;
     int op_size;
-    char *source_label, *dest_label;
-    static memory_word temp[MAX_OPERATION_LEN];
+    unsigned int source_label, dest_label;
+    memory_word temp[MAX_OPERATION_LEN]; /* per call, so parallel assemblies do not share it */
     for (i = 0; i < MAX_OPERATION_LEN; i++) {
         temp[i].data.value = 0;
     }
     /*set A to 1 for the first word of the operation*/
     temp->operation.A = 1;
-    op_size = parse_operation(work_line, line_number, temp, status,
+    op_size = parse_operation(line, line_number, temp, status,
                                   &source_label, &dest_label);
-    if (source_label != NULL) {
+    for (i = 0; i < op_size; i++) {
+        *image_word(code_image, IC + i) = temp[i];
+    }
+    if (source_label != NO_SYMBOL) {
         if (temp->operation.source_type == DIRECT) {
-            add_new_intern(table, source_label, IC + 1, immediate);
+            add_reference(table, label_table, code_image, source_label, IC + 1, immediate);
         } else if (temp->operation.source_type == RELATIVE) {
-            add_new_intern(table, source_label, IC + 1, relative);
+            add_reference(table, label_table, code_image, source_label, IC + 1, relative);
         }
     }
-    if (dest_label != NULL) {
+    if (dest_label != NO_SYMBOL) {
         if (temp->operation.dest_type == DIRECT) {
-            add_new_intern(table, dest_label, IC + op_size - 1, immediate);
+            add_reference(table, label_table, code_image, dest_label, IC + op_size - 1, immediate);
         } else if (temp->operation.dest_type == RELATIVE) {
-            add_new_intern(table, dest_label, IC + op_size - 1, relative);
+            add_reference(table, label_table, code_image, dest_label, IC + op_size - 1, relative);
         }
     }
-    for (i = 0; i < op_size; i++) {
-        code_image[IC + i] = temp[i];
-    }
     return op_size;
 }
\ No newline at end of file
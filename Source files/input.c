@@ -1,73 +1,198 @@
+#define _POSIX_C_SOURCE 200112L /* for mmap, fstat and read */
 #include "input.h"
 #include "memory_utility.h"
 #include "parsing.h"
 #include "first_pass.h"
 #include "const_tables.h"
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
- * Function: getLine
- * Purpose: Reads a line of text from the given input file.
+ * Function: read_whole_file
+ * Purpose: Reads the remaining contents of a descriptor into one buffer.
  *
- * This function dynamically allocates memory to store the characters of a line from a file.
- * It reads characters one by one until it encounters a newline or EOF (End of File).
- * If the allocated memory is not enough, the function doubles the memory and continues reading.
- * If an error occurs during memory allocation or file reading, the function handles it and returns NULL.
+ * This is the fallback for inputs that cannot be mapped, such as pipes. The buffer
+ * is filled with large read() calls and doubled when full; being the most recent
+ * allocation, it is usually grown in place.
  *
  * Parameters:
- *   - FILE *input: The file pointer from which the line is to be read.
+ *   - reader: The reader whose data and size are filled in.
+ *   - fd: The descriptor to read from.
  *
  * Returns:
- *   - A pointer to a string (char*) containing the line of text, or NULL if an error occurs or EOF is reached.
+ *   - 1 on success, 0 on a read error.
  */
-char *getLine(FILE *input) {
-    /*
-     * current_idx: Tracks the current position in the line.
-     * c: Character read from the file.
-     * line_size: The initial size of the line buffer.
-     * line: Pointer to the line buffer to store the text.
-     * new_line: Temporary pointer used for reallocating memory.
-     */
-    int current_idx = 0;
-    char c;
-    int line_size = STARTING_LINE_SIZE;
-    char *line;
-    char *new_line;
+static int read_whole_file(line_reader *reader, const int fd) {
+    size_t capacity = READ_CHUNK_SIZE;
+    ssize_t bytes_read;
 
-    /* Allocate initial memory for the line buffer */
-    line = (char *) safe_alloc(line_size * sizeof(char));
-    /* Continuously read characters until a newline or EOF is encountered */
-    while (1) {
-        c = (char) fgetc(input);
-
-        /* Check for error or End Of File */
-        if (c == EOF) {
-            if (current_idx == 0) {
-                free_ptr(line);  /* If no characters were read, free memory and return NULL */
-                return NULL;
-            }
-            break;  /* EOF reached */
+    reader->data = safe_alloc(capacity + 1);
+    reader->size = 0;
+    while ((bytes_read = read(fd, reader->data + reader->size, capacity - reader->size)) != 0) {
+        if (bytes_read < 0) {
+            return 0;
         }
-        if (c == '\n') {
-            break;  /* Newline character encountered */
+        reader->size += (size_t) bytes_read;
+        if (reader->size == capacity) {
+            reader->data = safe_realloc(reader->data, capacity + 1, 2 * capacity + 1);
+            capacity *= 2;
         }
+    }
+    reader->data[reader->size] = '\0';
+    reader->source = READER_BUFFERED;
+    return 1;
+}
 
-        /* Store the read character in the line buffer */
-        line[current_idx++] = c;
+/*
+ * Function: open_line_reader
+ * Purpose: Makes the whole contents of a file available for line-by-line access.
+ *
+ * Regular files are mapped with a private, writable mapping so that next_line can
+ * terminate lines in place without touching the file on disk. The last line needs a
+ * terminator too: it is either a newline or the zero fill after the end of the file
+ * in its last page. When neither exists (the file ends exactly on a page boundary
+ * without a newline), or the input is not a regular file, the contents are read
+ * into a buffer instead.
+ *
+ * Parameters:
+ *   - reader: The reader to initialise.
+ *   - file_name: The path of the file to open.
+ *
+ * Returns:
+ *   - 1 on success, 0 if the file could not be opened or read.
+ */
+int open_line_reader(line_reader *reader, const char *file_name) {
+    struct stat info;
+    const long page_size = sysconf(_SC_PAGESIZE);
+    int success;
+    int fd = open(file_name, O_RDONLY);
 
-        /* If buffer is full, allocate more memory */
-        if (current_idx >= line_size) {
-            line_size *= 2;  /* Double the buffer size */
-            new_line = safe_alloc(line_size);
-            memcpy(new_line, line, current_idx);
-            free_ptr(line);
-            line = new_line;  /* Update the line pointer to the newly allocated memory */
+    if (fd < 0) {
+        return 0;
+    }
+    reader->position = 0;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        reader->size = (size_t) info.st_size;
+        reader->data = mmap(NULL, reader->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (reader->data != MAP_FAILED) {
+            if (info.st_size % page_size != 0 || reader->data[reader->size - 1] == '\n') {
+                posix_madvise(reader->data, reader->size, POSIX_MADV_SEQUENTIAL);
+                reader->source = READER_MAPPED;
+                close(fd);
+                return 1;
+            }
+            munmap(reader->data, reader->size);  /* No room to terminate the last line */
         }
     }
+    success = read_whole_file(reader, fd);
+    close(fd);
+    return success;
+}
+
+/*
+ * Function: open_buffer_reader
+ * Purpose: Makes the lines of an in-memory text buffer available to next_line.
+ *
+ * Parameters:
+ *   - reader: The reader to initialise.
+ *   - buffer: The text to read, which stays owned by the caller.
+ */
+void open_buffer_reader(line_reader *reader, text_buffer *buffer) {
+    reader->data = buffer->text;
+    reader->size = buffer->length;
+    reader->position = 0;
+    reader->source = READER_BORROWED;
+}
+
+/*
+ * Function: next_line
+ * Purpose: Hands out the next line of the file without copying it.
+ *
+ * The newline ending the line is replaced with '\0'. The returned view stays valid
+ * until the reader is closed.
+ *
+ * Parameters:
+ *   - reader: The reader to take the line from.
+ *   - length: Output: the number of characters in the line (may be NULL).
+ *
+ * Returns:
+ *   - A pointer to the line, or NULL at end of file.
+ */
+char *next_line(line_reader *reader, size_t *length) {
+    char *line, *end;
+
+    if (reader->position >= reader->size) {
+        return NULL;
+    }
+    line = reader->data + reader->position;
+    end = memchr(line, '\n', reader->size - reader->position);
+    if (end == NULL) {
+        end = reader->data + reader->size;  /* Last line, already followed by a '\0' */
+    }
+    *end = '\0';
+    reader->position = (size_t) (end - reader->data) + 1;
+    if (length != NULL) {
+        *length = (size_t) (end - line);
+    }
+    return line;
+}
+
+/*
+ * Function: close_line_reader
+ * Purpose: Releases the contents held by a reader.
+ *
+ * Parameters:
+ *   - reader: The reader to close.
+ */
+void close_line_reader(line_reader *reader) {
+    if (reader->source == READER_MAPPED) {
+        munmap(reader->data, reader->size);
+    } else if (reader->source == READER_BUFFERED) {
+        free_ptr(reader->data);
+    }
+    reader->data = NULL;
+    reader->size = reader->position = 0;
+}
+
+/*
+ * Function: init_text_buffer
+ * Purpose: Initialises an empty text buffer.
+ *
+ * Parameters:
+ *   - buffer: The buffer to initialise.
+ *   - capacity: The number of characters to reserve up front.
+ */
+void init_text_buffer(text_buffer *buffer, const size_t capacity) {
+    buffer->capacity = capacity > 0 ? capacity : READ_CHUNK_SIZE;
+    buffer->text = safe_alloc(buffer->capacity + 1);
+    buffer->text[0] = '\0';
+    buffer->length = 0;
+}
 
-    /* Null-terminate the string */
-    line[current_idx] = '\0';
-    return line;  /* Return the complete line */
+/*
+ * Function: append_text
+ * Purpose: Appends characters to a text buffer, keeping it '\0'-terminated.
+ *
+ * Parameters:
+ *   - buffer: The buffer to append to.
+ *   - text: The characters to append.
+ *   - length: The number of characters to append.
+ */
+void append_text(text_buffer *buffer, const char *text, const size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t new_capacity = 2 * buffer->capacity;
+        while (buffer->length + length > new_capacity) {
+            new_capacity *= 2;
+        }
+        buffer->text = safe_realloc(buffer->text, buffer->capacity + 1, new_capacity + 1);
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->text + buffer->length, text, length);
+    buffer->length += length;
+    buffer->text[buffer->length] = '\0';
 }
 
 /**
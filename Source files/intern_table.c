@@ -11,95 +11,161 @@
  * Purpose:
  * This file defines functions and structures for managing interned labels in
  * the assembler project, particularly focusing on code and data labels. It
- * includes functions for creating new interned labels, finding an interned
- * label by name, passing on the interns table, adding intern to an existing
- * intern table, and freeing the list of interned labels.
+ * includes functions for creating an intern table, appending interned labels
+ * to it, and resolving them against the label table.
+ *
+ * References are resolved by backpatching. A reference to a label whose
+ * address is known when it is read is patched right away, and never enters
+ * the table. Any other reference is recorded and chained from the slot of its
+ * label, so defining a code label patches exactly the references waiting for
+ * it. Only immediate references to data labels, which need the final
+ * instruction counter, and references to external labels are left for the
+ * second pass.
  *
  * Key Structures:
- * - `Intern`: A structure to hold interned labels with a name, type (code or
- * data), memory location, and a pointer to the next interned label in a linked
- * list.
+ * - `intern_node`: A record holding an interned label with a symbol, type
+ * (immediate or relative) and memory location.
+ * - `intern_table_head`: A growable array of intern records kept in insertion
+ * order, so appending is amortised O(1) and a record's index gives its place
+ * in code order. The records of a label are linked through their next fields.
  *
  * Key Functions:
- * - `str_dup`: Duplicates a string by allocating memory and copying the
- * content.
- * - `new_intern`: Creates a new interned label and returns a pointer to it.
- * - `find_intern`: Searches for an interned label by name in a linked list.
- * - `free_list`: Frees the memory used by the interned labels linked list.
+ * - `add_new_intern`: Appends an interned label to the table.
+ * - `add_reference`: Patches a reference, or chains it to its label.
+ * - `resolve_references`: Patches the references waiting for a label.
+ * - `initialise_intern_table`: Creates an empty intern table.
  */
 
 /**
- * Function: add_intern
- * Purpose: Creates a new interned label with a given name, type, and memory location.
+ * Function: add_new_intern
+ * Purpose: Adds a new interned label to the intern table.
  *
- * This function dynamically allocates memory for a new interned label and initializes
- * its fields (name, type, memory location, and next pointer). It returns a pointer to
- * the newly created interned label.
+ * This function appends a record to the intern table's array, doubling the
+ * capacity of the array when it is full.
  *
  * Parameters:
- *   - char* name: The name of the interned label.
- *   - intern_type type: The type of the interned label (code or data).
+ *   - intern_table_head* head: The head of the intern table.
+ *   - unsigned int symbol: The interned name of the label.
  *   - int mem_place: The memory location of the interned label.
- *   - intern_node table: A pointer to the head of the intern table.
+ *   - intern_type type: The type of the interned label (code or data).
+ */
+void add_new_intern(intern_table_head *head, unsigned int symbol, int mem_place, intern_type type) {
+  intern_node *node;
+  if (head->count == head->capacity) {
+    head->items = safe_realloc(head->items, head->capacity * sizeof(intern_node),
+                               2 * head->capacity * sizeof(intern_node));
+    head->capacity *= 2;
+  }
+  node = &head->items[head->count++];
+  node->symbol = symbol;
+  node->mem_place = mem_place;
+  node->type = type;
+  node->next = NO_FIXUP;
+}
+
+/**
+ * Function: is_resolvable
+ * Purpose: Tells whether a reference to a label can be patched before the end of the source.
+ *
+ * Parameters:
+ *   - const label_node* label: The label referred to.
+ *   - intern_type type: The type of reference (immediate or relative).
  *
  * Returns:
- *   - intern_node*: A pointer to the newly created interned label.
+ *   - int: 1 if the label's value is final for this reference, 0 otherwise.
  */
-intern_node* add_intern(char* name, intern_type type, int mem_place, intern_node table) {
-  intern_node* new_intern = (intern_node*)safe_alloc(sizeof(intern_node));  /* Allocate memory for the new interned label. */
-  new_intern->name = name;  /* Duplicate the name of the interned label. */
-  new_intern->type = type;  /* Set the type (code or data) of the interned label. */
-  new_intern->mem_place = mem_place;  /* Set the memory location of the interned label. */
-  new_intern->next_intern = NULL;  /* Initialize the next pointer to NULL, indicating the end of the list. */
-  return new_intern;  /* Return the newly created interned label. */
+static int is_resolvable(const label_node *label, intern_type type) {
+  if (label->type == UNDEFINED || label->linking_type == EXTERN) {
+    return 0;
+  }
+  /* a data label moves past the code, except for the distance a relative reference takes */
+  return type == relative || label->type == CODE;
 }
 
 /**
- * Function: add_intern_node
- * Purpose: Adds an interned node to the end of the interned label list.
+ * Function: patch_reference
+ * Purpose: Writes the value of a label into the word referring to it.
  *
  * Parameters:
- *   - intern_node* node: The interned node to be added.
- *   - intern_node* curr: The current intern node in the list.
+ *   - memory* code_image: The code image holding the word.
+ *   - const label_node* label: The label referred to, whose value is final.
+ *   - intern_type type: The type of reference (immediate or relative).
+ *   - int mem_place: The address of the word.
  */
-void add_intern_node(intern_node *node, intern_node *curr) {
-    while (curr->next_intern != NULL) {
-        curr = curr->next_intern;
-    }
-    curr->next_intern = node;
+static void patch_reference(memory *code_image, const label_node *label, intern_type type,
+                            int mem_place) {
+  memory_word *word = image_word(code_image, mem_place);
+  if (type == immediate) {
+    word->operand.value = label->value;
+    word->operand.R = 1;
+  } else {
+    word->operand.A = 1;
+    word->operand.value = label->value - mem_place + 1;
+  }
 }
 
 /**
- * Function: add_new_intern
- * Purpose: Adds a new interned label to the intern table.
+ * Function: add_reference
+ * Purpose: Resolves a reference to a label in a code word.
  *
- * This function creates a new interned label and appends it to the intern table.
+ * The reference is patched at once if the label's value is already final;
+ * otherwise it is recorded and pushed on the chain of the label.
  *
  * Parameters:
- *   - intern_table_head* head: The head of the intern table.
- *   - const char* name: The name of the interned label.
- *   - int mem_place: The memory location of the interned label.
- *   - intern_type type: The type of the interned label (code or data).
+ *   - intern_table_head* head: The intern table holding the pending references.
+ *   - label_table_head* labels: The label table.
+ *   - memory* code_image: The code image holding the word.
+ *   - unsigned int symbol: The interned name of the label.
+ *   - int mem_place: The address of the word referring to the label.
+ *   - intern_type type: The type of reference (immediate or relative).
  */
-void add_new_intern(intern_table_head *head, char *name, int mem_place, intern_type type) {
-  intern_node *node = safe_alloc(sizeof(intern_node));
-  node->name = name;
-  node->mem_place = mem_place;
-  node->type = type;
-  node->next_intern = NULL;
-  if (head->root == NULL) {
-    head->root = node;
+void add_reference(intern_table_head *head, label_table_head *labels, memory *code_image,
+                   unsigned int symbol, int mem_place, intern_type type) {
+  label_node *label = reference_label(labels, symbol);
+  if (is_resolvable(label, type)) {
+    patch_reference(code_image, label, type, mem_place);
     return;
   }
-  add_intern_node(node, head->root);
+  add_new_intern(head, symbol, mem_place, type);
+  head->items[head->count - 1].next = label->fixups;
+  label->fixups = head->count - 1;
+}
+
+/**
+ * Function: resolve_references
+ * Purpose: Patches the pending references to a label that was just defined.
+ *
+ * Each patched record is marked resolved and unlinked; the records that still
+ * wait for the end of the source stay on the chain.
+ *
+ * Parameters:
+ *   - intern_table_head* head: The intern table holding the pending references.
+ *   - label_node* label: The label that was defined.
+ *   - memory* code_image: The code image holding the words.
+ */
+void resolve_references(intern_table_head *head, label_node *label, memory *code_image) {
+  int i = label->fixups;
+  int *link = &label->fixups;
+  intern_node *current;
+  while (i != NO_FIXUP) {
+    current = &head->items[i];
+    i = current->next;
+    if (is_resolvable(label, current->type)) {
+      patch_reference(code_image, label, current->type, current->mem_place);
+      current->type = resolved;
+      *link = i;
+    } else {
+      link = &current->next;
+    }
+  }
 }
 
 /**
  * Function: initialise_intern_table
  * Purpose: Initializes an intern table.
  *
- * This function creates an intern table structure and initializes its root pointer
- * to NULL.
+ * This function creates an intern table structure with room for
+ * TABLE_STARTING_CAPACITY records.
  *
  * Parameters:
  *   - None
@@ -109,38 +175,8 @@ void add_new_intern(intern_table_head *head, char *name, int mem_place, intern_t
  */
 intern_table_head *initialise_intern_table() {
   intern_table_head *root = safe_alloc(sizeof(intern_table_head));
-  root->root = NULL;
+  root->items = safe_alloc(TABLE_STARTING_CAPACITY * sizeof(intern_node));
+  root->count = 0;
+  root->capacity = TABLE_STARTING_CAPACITY;
   return root;
 }
-
-/**
- * Function: check_interns_in_labels
- * Purpose: Verifies all interns against the label table.
- *
- * This function traverses the intern list and checks if each interned label
- * exists in the label table. It returns 1 if at least one intern is found.
- * If any intern is not found, it calls an error handler but continues checking the rest.
- *
- * Parameters:
- *   - intern_table_head* intern_head: Pointer to the intern table.
- *   - label_table_head* label_head: Pointer to the label table.
- *
- * Returns:
- *   - int: 1 if at least one intern is found in the label table, 0 otherwise.
- */
-int check_interns_in_labels(intern_table_head *intern_head, label_table_head *label_head) {
-    intern_node *current = intern_head->root;
-    int found_interns = 0;
-
-    while (current != NULL) {
-        label_node *label = find_label(current->name, *label_head);
-        if (label != NULL) {
-            found_interns = 1;
-        } else {
-            MISSING_INTERN(current->name); /* missing intern*/
-        }
-        current = current->next_intern;
-    }
-
-    return found_interns;
-}
\ No newline at end of file
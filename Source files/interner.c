@@ -0,0 +1,260 @@
+#include "interner.h"
+#include "memory_utility.h"
+#include <string.h>
+
+/*
+ * Purpose:
+ * This file implements the string interner. The strings are kept in an array
+ * indexed by id, and a power-of-two hash index of ids finds the id of a string
+ * with one probe sequence. The index stores ids rather than pointers, so growing
+ * the symbol array never invalidates it, and the stored hashes mean growing the
+ * index never hashes a string again. New strings are copied into a pool of large
+ * blocks, so the lexer interns an identifier without an allocation of its own.
+ *
+ * Key Functions:
+ * - `hash_text`: Hashes a string slice.
+ * - `init_interner`: Prepares an interner presized for a source.
+ * - `intern`: Finds or adds a string and returns its id.
+ * - `find_symbol`: Finds the id of a string without adding it.
+ * - `restore_symbol`: Adds a string kept outside the interner, e.g. in a .amt file.
+ * - `symbol_name`: Returns the string of an id.
+ */
+
+/* The index is grown once more than LOAD_NUMERATOR/LOAD_DENOMINATOR of the slots are used */
+#define LOAD_NUMERATOR 7
+#define LOAD_DENOMINATOR 10
+
+/**
+ * Function: hash_text
+ * Purpose: Computes the FNV-1a hash of a string slice.
+ *
+ * Parameters:
+ *   - text: The first character of the string.
+ *   - length: The number of characters in the string.
+ *
+ * Returns:
+ *   - The hash of the string.
+ */
+unsigned long hash_text(const char *text, size_t length) {
+  unsigned long hash = 2166136261UL;
+  while (length-- > 0) {
+    hash ^= (unsigned char)*text++;
+    hash = (hash * 16777619UL) & 0xffffffffUL;
+  }
+  return hash;
+}
+
+/**
+ * Function: allocate_index
+ * Purpose: Allocates the symbol array and an empty hash index for a capacity.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - capacity: The number of slots, a power of two.
+ */
+static void allocate_index(interner *symbols, const unsigned int capacity) {
+  symbols->slots = safe_alloc(capacity * sizeof(unsigned int));
+  memset(symbols->slots, 0, capacity * sizeof(unsigned int));
+  symbols->capacity = capacity;
+}
+
+/**
+ * Function: init_interner
+ * Purpose: Prepares an empty interner presized for the expected number of symbols.
+ *
+ * Parameters:
+ *   - symbols: The interner to initialise.
+ *   - expected_symbols: The number of symbols expected.
+ */
+void init_interner(interner *symbols, const size_t expected_symbols) {
+  unsigned int capacity = INTERNER_MIN_CAPACITY;
+  while (capacity / LOAD_DENOMINATOR * LOAD_NUMERATOR < expected_symbols) {
+    capacity *= 2;
+  }
+  symbols->symbols = safe_alloc(capacity * sizeof(symbol));
+  symbols->count = 0;
+  symbols->pool = NULL;
+  symbols->pool_free = 0;
+  allocate_index(symbols, capacity);
+}
+
+/**
+ * Function: find_index_slot
+ * Purpose: Probes the hash index for a string.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - text: The first character of the string.
+ *   - length: The number of characters in the string.
+ *   - hash: The hash of the string.
+ *
+ * Returns:
+ *   - The slot holding the id of the string, or the empty slot where it belongs.
+ */
+static unsigned int *find_index_slot(const interner *symbols, const char *text,
+                                     const size_t length, const unsigned long hash) {
+  const unsigned long mask = (unsigned long)symbols->capacity - 1;
+  unsigned long i = hash & mask;
+  const symbol *candidate;
+
+  while (symbols->slots[i] != 0) {
+    candidate = &symbols->symbols[symbols->slots[i] - 1];
+    if (candidate->hash == hash && candidate->length == length &&
+        memcmp(candidate->name, text, length) == 0) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return &symbols->slots[i];
+}
+
+/**
+ * Function: grow_interner
+ * Purpose: Doubles the capacity and rebuilds the index from the stored hashes.
+ *
+ * Parameters:
+ *   - symbols: The interner to grow.
+ */
+static void grow_interner(interner *symbols) {
+  const unsigned int old_capacity = symbols->capacity;
+  const symbol *entry;
+  unsigned int id;
+
+  symbols->symbols = safe_realloc(symbols->symbols, old_capacity * sizeof(symbol),
+                                  2 * old_capacity * sizeof(symbol));
+  allocate_index(symbols, 2 * old_capacity);
+  for (id = 0; id < symbols->count; id++) {
+    entry = &symbols->symbols[id];
+    *find_index_slot(symbols, entry->name, entry->length, entry->hash) = id + 1;
+  }
+}
+
+/**
+ * Function: add_symbol
+ * Purpose: Gives the next id to a string that is not interned yet, growing the interner as needed.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - name: The '\0'-terminated string, which must outlive the interner.
+ *   - length: The number of characters in the string.
+ *   - hash: The hash of the string.
+ *
+ * Returns:
+ *   - The id of the string.
+ */
+static unsigned int add_symbol(interner *symbols, const char *name, const size_t length,
+                               const unsigned long hash) {
+  symbol *entry;
+
+  if ((symbols->count + 1) * LOAD_DENOMINATOR > symbols->capacity * LOAD_NUMERATOR) {
+    grow_interner(symbols);
+  }
+  entry = &symbols->symbols[symbols->count];
+  entry->name = name;
+  entry->length = length;
+  entry->hash = hash;
+  *find_index_slot(symbols, name, length, hash) = ++symbols->count;
+  return symbols->count - 1;
+}
+
+/**
+ * Function: pool_string
+ * Purpose: Copies a string into the pool, starting a new block when the current one is full.
+ *
+ * A string longer than a block gets a block of its own; the rest of a full block
+ * is left unused.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - text: The first character of the string.
+ *   - length: The number of characters in the string.
+ *
+ * Returns:
+ *   - The '\0'-terminated copy.
+ */
+static char *pool_string(interner *symbols, const char *text, const size_t length) {
+  char *name;
+
+  if (length + 1 > symbols->pool_free) {
+    symbols->pool_free = length + 1 > INTERNER_POOL_SIZE ? length + 1 : INTERNER_POOL_SIZE;
+    symbols->pool = safe_alloc(symbols->pool_free);
+  }
+  name = symbols->pool;
+  memcpy(name, text, length);
+  name[length] = '\0';
+  symbols->pool += length + 1;
+  symbols->pool_free -= length + 1;
+  return name;
+}
+
+/**
+ * Function: intern
+ * Purpose: Returns the id of a string, pooling a copy of it if it is new.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - text: The first character of the string.
+ *   - length: The number of characters in the string.
+ *
+ * Returns:
+ *   - The id of the string.
+ */
+unsigned int intern(interner *symbols, const char *text, const size_t length) {
+  const unsigned long hash = hash_text(text, length);
+  const unsigned int *slot = find_index_slot(symbols, text, length, hash);
+
+  if (*slot != 0) {
+    return *slot - 1;
+  }
+  return add_symbol(symbols, pool_string(symbols, text, length), length, hash);
+}
+
+/**
+ * Function: find_symbol
+ * Purpose: Returns the id of a string if it is interned, without interning it.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - text: The first character of the string.
+ *   - length: The number of characters in the string.
+ *
+ * Returns:
+ *   - The id of the string, or NO_SYMBOL if it is not interned.
+ */
+unsigned int find_symbol(const interner *symbols, const char *text, const size_t length) {
+  /* an empty slot holds 0, which gives NO_SYMBOL */
+  return *find_index_slot(symbols, text, length, hash_text(text, length)) - 1;
+}
+
+/**
+ * Function: restore_symbol
+ * Purpose: Adds a string the interner does not own, such as one in a mapped .amt file.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - name: The '\0'-terminated string, not interned yet.
+ *   - length: The number of characters in the string.
+ *   - hash: The hash of the string, as computed by hash_text.
+ *
+ * Returns:
+ *   - The id of the string.
+ */
+unsigned int restore_symbol(interner *symbols, const char *name, const size_t length,
+                            const unsigned long hash) {
+  return add_symbol(symbols, name, length, hash);
+}
+
+/**
+ * Function: symbol_name
+ * Purpose: Returns the interned string of an id.
+ *
+ * Parameters:
+ *   - symbols: The interner.
+ *   - id: The id of the string.
+ *
+ * Returns:
+ *   - The '\0'-terminated string.
+ */
+const char *symbol_name(const interner *symbols, const unsigned int id) {
+  return symbols->symbols[id].name;
+}
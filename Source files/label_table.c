@@ -3,7 +3,6 @@
 #include "first_pass.h"
 #include "const_tables.h"
 #include "memory_utility.h"
-#include <string.h>
 
 /*
  * Purpose:
@@ -11,171 +10,180 @@
  * assembler project, including functionality for creating a label table, adding
  * labels to the table, and searching for labels by their name.
  *
+ * Every label name is interned, so the table is a plain array indexed by the
+ * id of the name: finding a label is one bounds check and one load, with no
+ * hashing, probing or string comparison. A slot is in use when it holds its
+ * own index as its symbol. A label that is only referenced so far holds its
+ * slot as UNDEFINED, which find_label treats as missing.
+ *
  * Key Structures:
- * - `table_head`: A structure representing the root of a binary search tree for
- * labels.
- * - `label`: A structure representing an individual label with fields such as
- * name, value, type, and linking type.
+ * - `label_table_head`: The slot array, its size and the interner naming the labels.
+ * - `label_node`: A slot holding an individual label with fields such as
+ * symbol, value, type, and linking type.
  *
  * Key Functions:
- * - `initialise_table`: Initializes a new label table.
- * - `node_cmp`: Compares two labels by their names.
- * - `add_node`: Adds a new label node to the binary search tree of labels.
+ * - `initialise_label_table`: Initializes a new label table with a slot for every symbol.
+ * - `grow_label_table`: Extends the table to cover more symbols.
+ * - `reference_label`: Claims the slot of a referenced label.
+ * - `find_or_add_label`: Looks a label up and inserts it if missing.
  * - `add_label`: Adds a label to the table, initializing the label node with
  * given data.
- * - `find_node`: Searches for a label node by name in the binary search tree.
  * - `find_label`: Finds a label by its name in the label table.
  */
 
+/**
+ * Function: clear_slots
+ * Purpose: Marks a range of slots empty.
+ *
+ * Parameters:
+ *   - label_node* slots: The slot array.
+ *   - unsigned int first: The first slot to clear.
+ *   - unsigned int end: The slot after the last one to clear.
+ */
+static void clear_slots(label_node *slots, unsigned int first, unsigned int end) {
+  for (; first < end; first++) {
+    slots[first].symbol = NO_SYMBOL;
+  }
+}
+
 /**
  * Function: initialise_label_table
- * Purpose: Initializes a new label table with a NULL root.
+ * Purpose: Initializes a new, empty label table.
  *
- * This function creates a label table structure and sets its root pointer
- * to `NULL`. This table will later hold label nodes organized in a binary
- * search tree.
+ * The table has a slot for each symbol interned so far, so a table made after
+ * the source is lexed only grows for names interned during the passes.
  *
  * Parameters:
- *   - None
+ *   - const interner* symbols: The interner naming the labels.
  *
  * Returns:
  *   - label_table_head*: A pointer to the newly initialized label table.
  */
-label_table_head *initialise_label_table() {
+label_table_head *initialise_label_table(const interner *symbols) {
   label_table_head *root = safe_alloc(sizeof(label_table_head));
-  root->root = NULL;
+  unsigned int capacity = symbols->count > LABEL_TABLE_MIN_CAPACITY ? symbols->count
+                                                                     : LABEL_TABLE_MIN_CAPACITY;
+  root->slots = safe_alloc(capacity * sizeof(label_node));
+  clear_slots(root->slots, 0, capacity);
+  root->capacity = capacity;
+  root->symbols = symbols;
   return root;
 }
 
 /**
- * Function: node_cmp
- * Purpose: Compares two label nodes by their names.
- *
- * This function compares the names of two label nodes using the `strcmp`
- * function. It returns the result of `strcmp` to determine their lexicographical order.
+ * Function: grow_label_table
+ * Purpose: Doubles the number of slots until there is one for a symbol.
  *
  * Parameters:
- *   - label_node node1: The first label node.
- *   - label_node node2: The second label node.
- *
- * Returns:
- *   - int: Result of `strcmp` between the names of `node1` and `node2`.
+ *   - label_table_head* head: The table to grow.
+ *   - unsigned int symbol: The symbol that needs a slot.
  */
-int node_cmp(label_node node1, label_node node2) {
-  return strcmp(node1.name, node2.name);
+static void grow_label_table(label_table_head *head, unsigned int symbol) {
+  unsigned int capacity = head->capacity;
+  while (capacity <= symbol) {
+    capacity *= 2;
+  }
+  head->slots = safe_realloc(head->slots, head->capacity * sizeof(label_node),
+                             capacity * sizeof(label_node));
+  clear_slots(head->slots, head->capacity, capacity);
+  head->capacity = capacity;
 }
 
 /**
- * Function: add_label_node
- * Purpose: Recursively adds a new label node to the correct position in the binary search tree
- *          of labels based on the comparison of names.
- *
- * This function compares the new label node's name with the current node in the tree
- * and inserts the new node in the left or right subtree accordingly.
+ * Function: reference_label
+ * Purpose: Returns the slot of a referenced label, claiming it if it is empty.
  *
  * Parameters:
- *   - label_node* node: The label node to be added.
- *   - label_node* curr: The current node in the tree where the new node will be inserted.
+ *   - label_table_head* head: The label table holding the label.
+ *   - unsigned int symbol: The interned name of the label.
+ *
+ * Returns:
+ *   - label_node*: The slot of the label; a claimed slot is UNDEFINED with no
+ *     pending references.
  */
-void add_label_node(label_node *node, label_node *curr) {
-  if (curr->left == NULL && curr->right == NULL) {
-    if (node_cmp(*node, *curr) >= 0) {
-      curr->right = node;
-    } else {
-      curr->left = node;
-    }
-    return;
+label_node *reference_label(label_table_head *head, unsigned int symbol) {
+  label_node *slot;
+  if (symbol >= head->capacity) {
+    grow_label_table(head, symbol);
   }
-  if (node_cmp(*node, *curr) >= 0) {
-    if (curr->right == NULL) {
-      curr->right = node;
-      return;
-    }
-    add_label_node(node, curr->right);
-  } else {
-    if (curr->left == NULL) {
-      curr->left = node;
-      return;
-    }
-    add_label_node(node, curr->left);
+  slot = &head->slots[symbol];
+  if (slot->symbol != symbol) {
+    slot->symbol = symbol;
+    slot->type = UNDEFINED;
+    slot->fixups = NO_FIXUP;
   }
+  return slot;
 }
 
 /**
- * Function: add_label
- * Purpose: Creates a new label node with the given data and adds it to the label table.
+ * Function: find_or_add_label
+ * Purpose: Looks a label up by name and claims its slot if it is missing.
  *
- * If the root of the table is `NULL`, the node becomes the root of the table.
- * Otherwise, it is added to the correct position in the binary search tree.
+ * A label that was only referenced keeps its pending references.
  *
  * Parameters:
- *   - label_table_head* head: The label table to which the label is being added.
- *   - const char* name: The name of the label.
- *   - int value: The value associated with the label.
- *   - label_data_type type: The type of the label (e.g., code or data).
- *   - linking_type linking_type: The type of linking (e.g., external or internal).
+ *   - label_table_head* head: The label table to search and insert into.
+ *   - unsigned int symbol: The interned name of the label.
+ *   - int* found: Set to 1 if the label was already defined, 0 if it was inserted.
+ *
+ * Returns:
+ *   - label_node*: The existing label, or the new slot with only its symbol and
+ *     pending references set.
  */
-void add_label(label_table_head *head, const char *name, int value,
-               label_data_type type, linking_type linking_type) {
-  label_node *node = safe_alloc(sizeof(label_node));
-  node->name = name;
-  node->value = value;
-  node->type = type;
-  node->linking_type = linking_type;
-  node->left = NULL;
-  node->right = NULL;
-  if (head->root == NULL) {
-    head->root = node;
-    return;
+label_node *find_or_add_label(label_table_head *head, unsigned int symbol, int *found) {
+  label_node *slot = reference_label(head, symbol);
+  if (slot->type != UNDEFINED) {
+    *found = 1;
+    return slot;
   }
-  add_label_node(node, head->root);
+  *found = 0;
+  return slot;
 }
 
 /**
- * Function: find_node
- * Purpose: Recursively searches for a label node by name in the binary search tree.
+ * Function: add_label
+ * Purpose: Adds a label with the given data to the label table.
  *
- * This function traverses the binary search tree by comparing the given `name` with
- * the current node's name and recursively moves to the left or right subtree until
- * the node is found or the end of the tree is reached.
+ * If a label with the same name already exists, the table is left unchanged.
  *
  * Parameters:
- *   - const char* name: The name of the label being searched for.
- *   - label_node* node: The current node being checked.
+ *   - label_table_head* head: The label table to which the label is being added.
+ *   - unsigned int symbol: The interned name of the label.
+ *   - int value: The value associated with the label.
+ *   - label_data_type type: The type of the label (e.g., code or data).
+ *   - linking_type linking_type: The type of linking (e.g., external or internal).
  *
  * Returns:
- *   - label_node*: A pointer to the label node if found, `NULL` otherwise.
+ *   - int: 1 if the label was added, 0 if the name was already taken.
  */
-label_node *find_node(const char *name, label_node *node) {
-  int compare;
-  if (node == NULL) {
-    return node;
-  }
-  compare = strcmp(name, node->name);
-  if (compare == 0) {
-    return node;
-  }
-  if (compare >= 0) {
-    return find_node(name, node->right);
+int add_label(label_table_head *head, unsigned int symbol, int value,
+              label_data_type type, linking_type linking_type) {
+  int found;
+  label_node *node = find_or_add_label(head, symbol, &found);
+  if (found) {
+    return 0;
   }
-  return find_node(name, node->left);
+  node->value = value;
+  node->type = type;
+  node->linking_type = linking_type;
+  return 1;
 }
 
 /**
  * Function: find_label
- * Purpose: Finds a label in the label table by its name by calling the recursive
- *          search function `find_node`.
- *
- * This function is a wrapper around the `find_node` function to search for a label
- * in the label table by its name.
+ * Purpose: Finds a label in the label table by its name.
  *
  * Parameters:
- *   - const char* name: The name of the label being searched for.
+ *   - unsigned int symbol: The interned name of the label being searched for.
  *   - label_table_head head: The label table being searched.
  *
  * Returns:
- *   - label_node*: A pointer to the label node if found, `NULL` otherwise.
+ *   - label_node*: A pointer to the label node if it is defined, `NULL` otherwise.
  */
-label_node *find_label(const char *name, label_table_head head) {
-  return find_node(name, head.root);
-}
\ No newline at end of file
+label_node *find_label(unsigned int symbol, label_table_head head) {
+  if (symbol >= head.capacity || head.slots[symbol].symbol != symbol ||
+      head.slots[symbol].type == UNDEFINED) {
+    return NULL;
+  }
+  return &head.slots[symbol];
+}
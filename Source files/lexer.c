@@ -0,0 +1,327 @@
+#include "lexer.h"
+#include "memory_utility.h"
+#include "const_tables.h"
+#include "scan.h"
+#include <string.h>
+
+/*
+ * Purpose:
+ * This file implements the lexer and the token stream. A line is tokenized in
+ * one left-to-right scan that looks at every character once; tokens are slices
+ * of the line, so the only thing ever copied out of the source is the first
+ * occurrence of each identifier, into the interner. Characters are classified
+ * with the char_classes table rather than <ctype.h>, so the scan is one table
+ * load per character whatever the locale.
+ *
+ * Key Functions:
+ * - `init_token_stream`: Prepares a stream presized for a source.
+ * - `lex_line`: Tokenizes a line onto the end of a stream.
+ * - `add_token_line`: Records a tokenized line.
+ * - `append_token_lines`: Copies the lines of a stream, e.g. a macro body, into another.
+ * - `open_token_cursor`, `peek_token`, `run_end`, `token_equals`: The parsers' view of a line.
+ */
+
+#define STRING_CHAR '"'   /* Opens and closes a string */
+#define STRING_DIRECTIVE "string"  /* The only instruction that takes a string */
+
+/**
+ * Function: init_token_stream
+ * Purpose: Prepares an empty stream with room for the expected tokens and lines.
+ *
+ * Parameters:
+ *   - stream: The stream to initialise.
+ *   - expected_tokens: The number of tokens to reserve.
+ *   - expected_lines: The number of lines to reserve.
+ */
+void init_token_stream(token_stream *stream, const size_t expected_tokens,
+                       const size_t expected_lines) {
+  stream->token_capacity = (int)expected_tokens + 1;
+  stream->tokens = safe_alloc(stream->token_capacity * sizeof(token));
+  stream->token_count = 0;
+  stream->line_capacity = (int)expected_lines + 1;
+  stream->lines = safe_alloc(stream->line_capacity * sizeof(token_line));
+  stream->line_count = 0;
+}
+
+/**
+ * Function: reserve_tokens
+ * Purpose: Makes room for more tokens, doubling the token array as needed.
+ *
+ * Parameters:
+ *   - stream: The stream.
+ *   - extra: The number of tokens about to be appended.
+ */
+static void reserve_tokens(token_stream *stream, const int extra) {
+  int capacity = stream->token_capacity;
+  while (stream->token_count + extra > capacity) {
+    capacity *= 2;
+  }
+  if (capacity != stream->token_capacity) {
+    stream->tokens = safe_realloc(stream->tokens, stream->token_capacity * sizeof(token),
+                                  capacity * sizeof(token));
+    stream->token_capacity = capacity;
+  }
+}
+
+/**
+ * Function: reserve_lines
+ * Purpose: Makes room for more lines, doubling the line array as needed.
+ *
+ * Parameters:
+ *   - stream: The stream.
+ *   - extra: The number of lines about to be appended.
+ */
+static void reserve_lines(token_stream *stream, const int extra) {
+  int capacity = stream->line_capacity;
+  while (stream->line_count + extra > capacity) {
+    capacity *= 2;
+  }
+  if (capacity != stream->line_capacity) {
+    stream->lines = safe_realloc(stream->lines, stream->line_capacity * sizeof(token_line),
+                                 capacity * sizeof(token_line));
+    stream->line_capacity = capacity;
+  }
+}
+
+/**
+ * Function: punctuation_kind
+ * Purpose: Returns the kind of a single-character token.
+ *
+ * Parameters:
+ *   - c: The character.
+ *
+ * Returns:
+ *   - The kind of the token made of the character.
+ */
+static token_kind punctuation_kind(const char c) {
+  switch (c) {
+    case ',':
+      return TOKEN_COMMA;
+    case ':':
+      return TOKEN_COLON;
+    case '#':
+      return TOKEN_HASH;
+    case '&':
+      return TOKEN_AMPERSAND;
+    case '.':
+      return TOKEN_DOT;
+    default:
+      return TOKEN_OTHER;
+  }
+}
+
+/**
+ * Function: expects_string
+ * Purpose: Checks if the tokens lexed so far on a line are a string instruction, the only
+ * place a string can start. Anywhere else a quotation mark is a character of its own, so
+ * a stray one does not swallow the whitespace that ends a word.
+ *
+ * Parameters:
+ *   - stream: The stream being lexed into.
+ *   - first: The index of the first token of the line.
+ *   - line: The line.
+ *
+ * Returns:
+ *   - 1 if the next token may be a string, 0 otherwise.
+ */
+static int expects_string(const token_stream *stream, const int first, const char *line) {
+  const token *name;
+  if (stream->token_count - first < 2) {
+    return 0;
+  }
+  name = &stream->tokens[stream->token_count - 1];
+  return name->kind == TOKEN_IDENTIFIER &&
+         (name - 1)->kind == TOKEN_DOT && (name - 1)->offset + 1 == name->offset &&
+         name->length == sizeof(STRING_DIRECTIVE) - 1 &&
+         memcmp(line + name->offset, STRING_DIRECTIVE, name->length) == 0;
+}
+
+/**
+ * Function: lex_line
+ * Purpose: Tokenizes a line and appends its tokens to the stream.
+ *
+ * Whitespace separates tokens and is not kept; runs of it, including the
+ * indentation and the whole of a blank line, are skipped with skip_spaces.
+ * Identifiers are interned as they are found, so equal identifiers anywhere in
+ * the source share one id. A string is only recognised right after a string
+ * instruction.
+ *
+ * Parameters:
+ *   - stream: The stream to append to.
+ *   - symbols: The interner for the identifiers.
+ *   - line: The line, without its newline.
+ *   - length: The number of characters in the line.
+ *
+ * Returns:
+ *   - The number of tokens appended.
+ */
+int lex_line(token_stream *stream, interner *symbols, const char *line, const size_t length) {
+  const int first = stream->token_count;
+  size_t i = 0, start;
+  unsigned char c;
+  int is_string;
+  token *tok;
+
+  while (i < length) {
+    c = (unsigned char)line[i];
+    if (CHAR_IS(c, CHAR_SPACE)) {
+      i += skip_spaces(line + i, length - i);
+      continue;
+    }
+    is_string = c == STRING_CHAR && expects_string(stream, first, line);
+    reserve_tokens(stream, 1);
+    tok = &stream->tokens[stream->token_count++];
+    tok->symbol = NO_SYMBOL;
+    start = i++;
+    if (start == 0 && CHAR_IS(c, CHAR_COMMENT)) {
+      tok->kind = TOKEN_COMMENT;
+      i = length;
+    } else if (CHAR_IS(c, CHAR_LABEL_START)) {
+      while (i < length && CHAR_IS(line[i], CHAR_LABEL)) {
+        i++;
+      }
+      tok->kind = TOKEN_IDENTIFIER;
+      tok->symbol = intern(symbols, line + start, i - start);
+    } else if (CHAR_IS(c, CHAR_DIGIT) ||
+               (CHAR_IS(c, CHAR_SIGN) && i < length && CHAR_IS(line[i], CHAR_DIGIT))) {
+      while (i < length && CHAR_IS(line[i], CHAR_DIGIT)) {
+        i++;
+      }
+      tok->kind = TOKEN_NUMBER;
+    } else if (is_string) {
+      while (i < length && line[i] != STRING_CHAR) {
+        i++;
+      }
+      if (i < length) {
+        i++; /* the closing quote */
+      }
+      tok->kind = TOKEN_STRING;
+    } else {
+      tok->kind = CHAR_IS(c, CHAR_SEPARATOR) ? punctuation_kind((char)c) : TOKEN_OTHER;
+    }
+    tok->offset = (unsigned int)start;
+    tok->length = (unsigned int)(i - start);
+  }
+  return stream->token_count - first;
+}
+
+/**
+ * Function: add_token_line
+ * Purpose: Records a line made of the last tokens of the stream.
+ *
+ * Parameters:
+ *   - stream: The stream.
+ *   - text_offset: The offset of the line in the source text.
+ *   - token_count: The number of tokens on the line.
+ */
+void add_token_line(token_stream *stream, const size_t text_offset, const int token_count) {
+  token_line *line;
+
+  reserve_lines(stream, 1);
+  line = &stream->lines[stream->line_count++];
+  line->text_offset = text_offset;
+  line->first_token = stream->token_count - token_count;
+  line->token_count = token_count;
+}
+
+/**
+ * Function: append_token_lines
+ * Purpose: Appends the lines and tokens of a stream to another in two block copies.
+ *
+ * Token offsets are relative to their line, so only the line records need to
+ * be moved to their new place in the text and in the token array.
+ *
+ * Parameters:
+ *   - stream: The stream to append to.
+ *   - lines: The stream whose lines are appended.
+ *   - text_offset: The offset in the source of the text of the first appended line.
+ */
+void append_token_lines(token_stream *stream, const token_stream *lines, const size_t text_offset) {
+  const int token_base = stream->token_count;
+  token_line *line;
+  int i;
+
+  reserve_tokens(stream, lines->token_count);
+  reserve_lines(stream, lines->line_count);
+  memcpy(stream->tokens + token_base, lines->tokens, lines->token_count * sizeof(token));
+  stream->token_count += lines->token_count;
+  for (i = 0; i < lines->line_count; i++) {
+    line = &stream->lines[stream->line_count++];
+    line->text_offset = lines->lines[i].text_offset + text_offset;
+    line->first_token = lines->lines[i].first_token + token_base;
+    line->token_count = lines->lines[i].token_count;
+  }
+}
+
+/**
+ * Function: open_token_cursor
+ * Purpose: Positions a cursor at the first token of a line.
+ *
+ * Parameters:
+ *   - cursor: The cursor to position.
+ *   - stream: The stream holding the line.
+ *   - line: The index of the line.
+ *   - text: The source text of the stream.
+ *   - symbols: The interner of the stream.
+ */
+void open_token_cursor(token_cursor *cursor, const token_stream *stream, const int line,
+                       const char *text, interner *symbols) {
+  const token_line *record = &stream->lines[line];
+
+  cursor->text = text + record->text_offset;
+  cursor->tokens = stream->tokens + record->first_token;
+  cursor->count = record->token_count;
+  cursor->position = 0;
+  cursor->symbols = symbols;
+}
+
+/**
+ * Function: peek_token
+ * Purpose: Returns the next token of a cursor.
+ *
+ * Parameters:
+ *   - cursor: The cursor.
+ *
+ * Returns:
+ *   - The next token, or NULL at the end of the line.
+ */
+const token *peek_token(const token_cursor *cursor) {
+  return cursor->position < cursor->count ? &cursor->tokens[cursor->position] : NULL;
+}
+
+/**
+ * Function: run_end
+ * Purpose: Finds the end of the run of adjacent tokens starting at a token.
+ *
+ * Parameters:
+ *   - cursor: The cursor of the line.
+ *   - first: The index of the first token of the run.
+ *
+ * Returns:
+ *   - The index of the first token that is preceded by whitespace, or the token count.
+ */
+int run_end(const token_cursor *cursor, const int first) {
+  int i;
+  for (i = first + 1; i < cursor->count; i++) {
+    if (cursor->tokens[i].offset != cursor->tokens[i - 1].offset + cursor->tokens[i - 1].length) {
+      break;
+    }
+  }
+  return i;
+}
+
+/**
+ * Function: token_equals
+ * Purpose: Checks if the text of a token is a given word.
+ *
+ * Parameters:
+ *   - cursor: The cursor of the line holding the token.
+ *   - tok: The token.
+ *   - word: The word.
+ *
+ * Returns:
+ *   - 1 if the token is exactly the word, 0 otherwise.
+ */
+int token_equals(const token_cursor *cursor, const token *tok, const char *word) {
+  return strlen(word) == tok->length && memcmp(cursor->text + tok->offset, word, tok->length) == 0;
+}
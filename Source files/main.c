@@ -1,9 +1,52 @@
-#include "first_pass.h"
-#include "parsing.h"
-#include "const_tables.h"
+#define _POSIX_C_SOURCE 200112L /* for pthreads */
+#include "assembler.h"
 #include "memory_utility.h"
-#include "preprocessor.h"
+#include "diagnostics.h"
+#include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Command-line option that also writes the expanded source to the .am file */
+#define EMIT_AM_OPTION "--emit-am"
+
+/* Command-line option that keeps the lexed source in the .amt file and reuses it */
+#define TOKEN_FILE_OPTION "--amt"
+
+/* Command-line options that also write, or only write, the binary .obb object file */
+#define BINARY_OBJECT_OPTION "--obb"
+#define BINARY_OBJECT_ONLY_OPTION "--obb-only"
+
+/* Command-line option that removes .ent and .ext files a source no longer produces */
+#define CLEAN_OPTION "--clean"
+
+/* Command-line option setting the number of files assembled in parallel (-j N or -jN) */
+#define JOBS_OPTION "-j"
+#define MAX_JOBS 64 /* Upper limit on the number of worker threads */
+
+/*
+ * Struct: file_job
+ * Represents one file given on the command line and the messages produced while
+ * assembling it, which are printed once the file is done.
+ */
+typedef struct {
+  assembler_ctx ctx;       /* The state of the file's assembly, including its messages */
+  int done;                /* Set once the file has been assembled */
+} file_job;
+
+/*
+ * Struct: job_queue
+ * The work shared by the worker threads. Workers take the next unassigned file
+ * and mark it done; the main thread prints finished files in command-line order.
+ */
+typedef struct {
+  file_job *jobs;          /* The files, in command-line order */
+  int job_count;           /* Number of files */
+  int next_job;            /* Index of the next file no worker has taken */
+  pthread_mutex_t lock;    /* Protects next_job and the done flags */
+  pthread_cond_t job_done; /* Signalled whenever a file is done */
+} job_queue;
 
 /*
  * Purpose:
@@ -16,24 +59,157 @@
  *
  * Functionality:
  * - Processes each file specified in the command line arguments.
- * - Calls the `preprocess` function on each file to handle preprocessing.
- * - Calls the `first_pass` function to execute the first pass of the assembler
- * on each file.
+ * - Gives each file an assembler context of its own and calls `assemble` on
+ * it, which runs the preprocessor, the first pass and the second pass.
+ * - The `--emit-am` option additionally writes the expanded source to the
+ * .am file, for debugging.
+ * - The `--amt` option keeps the lexed source of each file in its .amt file
+ * and, as long as the .as file does not change, loads it from there instead
+ * of preprocessing and lexing the source again. A change is detected by the
+ * size and a 64-bit digest of the .as file, so an edit that keeps both would
+ * reuse stale tokens; the odds of that are about 1 in 2^64, and deleting the
+ * .amt file always forces a fresh run. A damaged .amt file fails its 64-bit
+ * checksum and is ignored; damage that keeps the checksum, with odds of about
+ * 1 in 2^64, would give wrong output.
+ * - The `--obb` option also writes the binary .obb object file, and
+ * `--obb-only` writes it instead of the .ob, .ent and .ext files.
+ * - A source without entries or externals writes no .ent or .ext file. One
+ * left by an earlier run stays unless the `--clean` option is given, which
+ * removes it; the check costs a lookup per file, so it is not done by default.
+ * - The `-j N` option assembles up to N files at the same time on a pool of
+ * worker threads; N runs from 1 to MAX_JOBS. Each context allocates from its own arena and collects the
+ * messages of its file in a buffer; the buffers are printed in command-line
+ * order, so the output is the same as in a sequential run.
  *
  * The main flow of the program includes:
  * 1. Checking the number of command-line arguments.
  * 2. Displaying an error message if no file is specified.
- * 3. Iterating over the list of files and calling `preprocess` and `first_pass`
- * on each.
- * 4. Cleaning up memory by calling `free_all_memory` after processing each
- * file.
+ * 3. Iterating over the list of files and calling `assemble` on each, either
+ * in order or on the worker pool. A file that fails to assemble does not
+ * stop the others.
+ * 4. Cleaning up memory by calling `release_assembler_ctx` after processing
+ * each file.
+ */
+
+/**
+ * Worker thread: repeatedly takes the next file from the queue and assembles it.
+ * The messages are kept in the file's context until the main thread prints them.
  *
- * @param argc The number of command-line arguments.
- * @param argv The array of command-line argument strings.
+ * @param arg The shared job_queue.
+ * @return void* Always NULL.
+ */
+static void *assemble_worker(void *arg) {
+  job_queue *queue = arg;
+  file_job *job;
+  int job_index;
+
+  while (1) {
+    pthread_mutex_lock(&queue->lock);
+    job_index = queue->next_job++;
+    pthread_mutex_unlock(&queue->lock);
+    if (job_index >= queue->job_count) {
+      break;
+    }
+    job = &queue->jobs[job_index];
+    assemble(&job->ctx);
+    release_assembler_ctx(&job->ctx);
+
+    pthread_mutex_lock(&queue->lock);
+    job->done = 1;
+    pthread_cond_broadcast(&queue->job_done);
+    pthread_mutex_unlock(&queue->lock);
+  }
+  return NULL;
+}
+
+/**
+ * Assembles the files on `thread_count` worker threads, printing the messages of
+ * each file as soon as it and every file before it are done. If no worker thread
+ * can be started, the files are assembled in order on the calling thread.
  *
- * @return int Returns 0 if successful, 1 if an error occurs (like missing file
- * argument).
+ * @param queue The files to assemble.
+ * @param thread_count The number of worker threads to start.
  */
+static void assemble_parallel(job_queue *queue, int thread_count) {
+  pthread_t threads[MAX_JOBS];
+  int i, started = 0;
+
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->job_done, NULL);
+  for (i = 0; i < thread_count; i++) {
+    if (pthread_create(&threads[started], NULL, assemble_worker, queue) == 0) {
+      started++;
+    }
+  }
+  if (started == 0) {
+    pthread_cond_destroy(&queue->job_done);
+    pthread_mutex_destroy(&queue->lock);
+    for (i = 0; i < queue->job_count; i++) {
+      assemble(&queue->jobs[i].ctx);
+      release_assembler_ctx(&queue->jobs[i].ctx);
+      flush_diagnostics(&queue->jobs[i].ctx.messages);
+      free_diagnostics(&queue->jobs[i].ctx.messages);
+    }
+    return;
+  }
+
+  /* Print the messages of each file in command-line order */
+  for (i = 0; i < queue->job_count; i++) {
+    pthread_mutex_lock(&queue->lock);
+    while (!queue->jobs[i].done) {
+      pthread_cond_wait(&queue->job_done, &queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    flush_diagnostics(&queue->jobs[i].ctx.messages);
+    free_diagnostics(&queue->jobs[i].ctx.messages);
+  }
+
+  for (i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_cond_destroy(&queue->job_done);
+  pthread_mutex_destroy(&queue->lock);
+}
+
+/**
+ * Tells whether a command-line argument is the jobs option: "-j" alone, or
+ * followed by digits. Anything else starting with "-j" is a file name.
+ *
+ * @param arg The argument.
+ * @return int 1 if it is the jobs option, 0 otherwise.
+ */
+static int is_jobs_option(const char *arg) {
+  const char *digit;
+  if (strncmp(arg, JOBS_OPTION, strlen(JOBS_OPTION)) != 0) {
+    return 0;
+  }
+  for (digit = arg + strlen(JOBS_OPTION); *digit != '\0'; digit++) {
+    if (!isdigit((unsigned char)*digit)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Parses the number of jobs, which must be a decimal number from 1 to MAX_JOBS with
+ * nothing after it.
+ *
+ * @param text The number.
+ * @return int The number of jobs, or 0 if the text is not a valid number of jobs.
+ */
+static int parse_job_count(const char *text) {
+  char *end;
+  long count;
+  if (!isdigit((unsigned char)*text)) {
+    return 0; /* strtol would also skip whitespace and take a sign */
+  }
+  count = strtol(text, &end, 10);
+  if (*end != '\0' || count < 1 || count > MAX_JOBS) {
+    return 0;
+  }
+  return (int)count;
+}
 
 /**
  * Entry point of the program.
@@ -45,22 +221,77 @@
  */
 int main(const int argc, char *argv[]) {
   int i;
-  struct Macro_table *macros;
-  /* Check if there are fewer than 2 command-line arguments */
-  if (argc < 2) {
+  int emit_am = 0, use_token_file = 0, remove_stale = 0, thread_count = 1;
+  int object_files = TEXT_OBJECT_FILES;
+  job_queue queue;
+
+  queue.jobs = malloc(argc * sizeof(file_job));
+  queue.job_count = 0;
+  queue.next_job = 0;
+  if (queue.jobs == NULL) {
+    MEM_ALOC_ERROR();
+    return 1;
+  }
+
+  /* Options may appear anywhere on the command line */
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], EMIT_AM_OPTION) == 0) {
+      emit_am = 1;
+    } else if (strcmp(argv[i], TOKEN_FILE_OPTION) == 0) {
+      use_token_file = 1;
+    } else if (strcmp(argv[i], CLEAN_OPTION) == 0) {
+      remove_stale = 1;
+    } else if (strcmp(argv[i], BINARY_OBJECT_OPTION) == 0) {
+      object_files = TEXT_OBJECT_FILES | BINARY_OBJECT_FILE;
+    } else if (strcmp(argv[i], BINARY_OBJECT_ONLY_OPTION) == 0) {
+      object_files = BINARY_OBJECT_FILE;
+    } else if (is_jobs_option(argv[i])) {
+      const char *count = argv[i] + strlen(JOBS_OPTION);
+      if (*count == '\0' && i + 1 < argc) {
+        count = argv[++i]; /* "-j N" form */
+      }
+      thread_count = parse_job_count(count);
+      if (thread_count < 1) {
+        printf("error: invalid number of jobs, expected 1 to %d\n", MAX_JOBS);
+        free(queue.jobs);
+        return 1;
+      }
+    } else {
+      queue.jobs[queue.job_count].ctx.file_name = argv[i];
+      queue.jobs[queue.job_count].done = 0;
+      queue.job_count++;
+    }
+  }
+  /* Check that at least one file was given */
+  if (queue.job_count == 0) {
     printf("error: missing argument\n"); /* Display error if no file is given */
+    free(queue.jobs);
     return 1;                            /* Return error code */
   }
 
-  /* Loop through each command-line argument (file to process) */
-  for (i = 1; i < argc; i++) {
-    printf("processing %s\n", argv[i]);
-    macros = preprocess(argv[i]); /* Call the preprocess function on the file */
-    if (macros == NULL) {
-      continue; /* Skip to the next file if preprocessing fails */
+  if (thread_count > queue.job_count) {
+    thread_count = queue.job_count;
+  }
+
+  /* Once the options are known, prepare a context for each file. Messages are
+   * printed as they happen unless the files are assembled in parallel. */
+  for (i = 0; i < queue.job_count; i++) {
+    init_assembler_ctx(&queue.jobs[i].ctx, queue.jobs[i].ctx.file_name, emit_am,
+                       thread_count > 1);
+    queue.jobs[i].ctx.use_token_file = use_token_file;
+    queue.jobs[i].ctx.object_files = object_files;
+    queue.jobs[i].ctx.remove_stale = remove_stale;
+  }
+
+  if (thread_count == 1) {
+    /* Loop through each file in order */
+    for (i = 0; i < queue.job_count; i++) {
+      assemble(&queue.jobs[i].ctx);
+      release_assembler_ctx(&queue.jobs[i].ctx);
     }
-    first_pass(argv[i], macros); /* Call the first pass assembler on the file */
-    free_all_memory();           /* Free memory after processing the file */
+  } else {
+    assemble_parallel(&queue, thread_count);
   }
+  free(queue.jobs);
   return 0; /* Return success code */
-}
\ No newline at end of file
+}
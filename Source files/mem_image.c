@@ -0,0 +1,79 @@
+#include "mem_image.h"
+#include "memory_utility.h"
+#include <string.h>
+
+/*
+ * Purpose:
+ * This file implements the growable memory images holding the encoded code and data.
+ * An image is a directory of page-sized chunks. Chunks are allocated from the arena the
+ * first time one of their words is used, and the directory doubles when an address lies
+ * past its end, so writing a word is bounds-safe at any address and never copies words.
+ *
+ * Key Functions:
+ * - `init_memory_image`: Prepares an image presized for a source.
+ * - `image_word`: Returns a word of the image, growing it as needed.
+ */
+
+/**
+ * Function: init_memory_image
+ * Purpose: Prepares an empty image with a chunk directory presized for the expected words.
+ *
+ * Parameters:
+ *   - image: The image to initialise.
+ *   - expected_words: The number of words the image is expected to hold.
+ */
+void init_memory_image(memory *image, const size_t expected_words) {
+  int i;
+
+  image->chunk_count = (int)(expected_words / MEMORY_CHUNK_WORDS) + 1;
+  image->chunks = safe_alloc(image->chunk_count * sizeof(memory_word *));
+  for (i = 0; i < image->chunk_count; i++) {
+    image->chunks[i] = NULL;
+  }
+}
+
+/**
+ * Function: grow_memory_image
+ * Purpose: Makes room in the chunk directory for the given chunk.
+ *
+ * Parameters:
+ *   - image: The image to grow.
+ *   - chunk: The index of the chunk that must fit in the directory.
+ */
+static void grow_memory_image(memory *image, const int chunk) {
+  int i, new_count = image->chunk_count > 0 ? 2 * image->chunk_count : 1;
+
+  while (new_count <= chunk) {
+    new_count *= 2;
+  }
+  image->chunks = safe_realloc(image->chunks, image->chunk_count * sizeof(memory_word *),
+                               new_count * sizeof(memory_word *));
+  for (i = image->chunk_count; i < new_count; i++) {
+    image->chunks[i] = NULL;
+  }
+  image->chunk_count = new_count;
+}
+
+/**
+ * Function: image_word
+ * Purpose: Returns the word at an address, allocating its chunk on first use.
+ *
+ * Parameters:
+ *   - image: The image holding the word.
+ *   - address: The non-negative address of the word.
+ *
+ * Returns:
+ *   - A pointer to the word.
+ */
+memory_word *image_word(memory *image, const int address) {
+  const int chunk = address / MEMORY_CHUNK_WORDS;
+
+  if (chunk >= image->chunk_count) {
+    grow_memory_image(image, chunk);
+  }
+  if (image->chunks[chunk] == NULL) {
+    image->chunks[chunk] = safe_alloc(MEMORY_CHUNK_WORDS * sizeof(memory_word));
+    memset(image->chunks[chunk], 0, MEMORY_CHUNK_WORDS * sizeof(memory_word));
+  }
+  return &image->chunks[chunk][address % MEMORY_CHUNK_WORDS];
+}
@@ -1,113 +1,325 @@
+#define _POSIX_C_SOURCE 200112L /* for pthread keys */
 #include "memory_utility.h"
 #include "errors.h"
-#include "parsing.h"
-#include "first_pass.h"
-#include "const_tables.h"
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
-static Memory_node *head = NULL;
+static Arena global_arena;
+
+/*
+ * The arena bound to the calling thread. With GCC and Clang it is a thread-local
+ * variable, so finding it costs one load; elsewhere it is kept under a pthread key.
+ */
+#if defined(__GNUC__)
+static __thread Arena *bound_arena;
+#else
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+#endif
 
 /*
  * Purpose:
- * This file implements memory management functions that ensure safe memory allocation,
- * track allocated memory blocks, and provide cleanup functions to free memory and avoid leaks.
- * It uses a linked list (`Memory_node`) to track all allocated memory pointers for proper management.
+ * This file implements memory management functions that ensure safe memory allocation
+ * and provide cleanup functions to free memory and avoid leaks.
+ * Memory is served from an arena: a stack of large chunks carved up with a bump pointer.
+ * Allocating is a pointer increment, and releasing a whole assembly is a handful of
+ * `free` calls regardless of how many blocks were handed out.
  *
  * Key Functions:
- * - `safe_alloc`: Allocates memory for a given size and tracks the pointer.
- * - `free_ptr`: Frees a specific memory block and removes it from the tracking list.
- * - `free_all_memory`: Frees all allocated memory tracked by the list.
+ * - `arena_alloc`: Bump-allocates a block from an arena.
+ * - `arena_free`: Rolls back the most recent allocation of an arena.
+ * - `arena_reset`: Releases all blocks of an arena at once.
+ * - `bind_arena`: Makes a thread allocate from its own arena.
+ * - `safe_alloc`: Allocates memory from the thread's arena and recovers or exits on failure.
+ * - `safe_realloc`: Grows a block, in place when it is the most recent one.
+ * - `free_ptr`: Frees a specific memory block when it can be reclaimed.
+ * - `free_all_memory`: Frees all allocated memory in one bulk release.
+ */
+
+/*
+ * Union used only to find the strictest alignment required by the basic types,
+ * so that every block handed out by the arena can hold any of them.
+ */
+typedef union {
+    long l;
+    double d;
+    void *p;
+} arena_align;
+
+#define ARENA_ALIGNMENT sizeof(arena_align)
+#define ALIGN_UP(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+#define CHUNK_HEADER_SIZE ALIGN_UP(sizeof(Arena_chunk))
+#define CHUNK_PAYLOAD(chunk) ((char *)(chunk) + CHUNK_HEADER_SIZE)
+
+/**
+ * Title: New Arena Chunk
+ *
+ * Purpose:
+ * Allocates a chunk with room for `size` payload bytes.
+ *
+ * @param size The payload capacity of the chunk.
+ * @return Arena_chunk* The new chunk, or NULL if malloc failed.
+ */
+static Arena_chunk *new_chunk(const size_t size) {
+    Arena_chunk *chunk = (Arena_chunk *)malloc(CHUNK_HEADER_SIZE + size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next_chunk = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+/**
+ * Title: Arena Allocation
+ *
+ * Purpose:
+ * Hands out an aligned block from the current chunk. When the chunk is full a new one
+ * is pushed on top of it. Requests larger than half a chunk get a dedicated chunk that
+ * is linked below the current one, so the free space of the current chunk is not wasted.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The size of memory to allocate.
+ * @return void* A pointer to the block, or NULL if a chunk could not be allocated.
+ */
+void *arena_alloc(Arena *arena, size_t size) {
+    Arena_chunk *chunk = arena->current;
+    void *ptr;
+
+    size = ALIGN_UP(size == 0 ? 1 : size);
+
+    /* Fast path: bump the pointer of the current chunk.*/
+    if (chunk != NULL && chunk->size - chunk->used >= size) {
+        ptr = CHUNK_PAYLOAD(chunk) + chunk->used;
+        chunk->used += size;
+        arena->last = ptr;
+        return ptr;
+    }
+
+    /* Large block: give it a chunk of its own below the current chunk.*/
+    if (size > ARENA_CHUNK_SIZE / 2) {
+        Arena_chunk *dedicated = new_chunk(size);
+        if (dedicated == NULL) {
+            return NULL;
+        }
+        dedicated->used = size;
+        if (chunk == NULL) {
+            arena->current = dedicated;
+        } else {
+            dedicated->next_chunk = chunk->next_chunk;
+            chunk->next_chunk = dedicated;
+        }
+        arena->last = NULL; /* not at the top of the current chunk */
+        return CHUNK_PAYLOAD(dedicated);
+    }
+
+    /* The current chunk is full, start a new one on top of it.*/
+    chunk = new_chunk(ARENA_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next_chunk = arena->current;
+    arena->current = chunk;
+    chunk->used = size;
+    arena->last = CHUNK_PAYLOAD(chunk);
+    return arena->last;
+}
+
+/**
+ * Title: Arena Free
+ *
+ * Purpose:
+ * Rolls the bump pointer back if `ptr` is the most recent allocation. Any other block
+ * stays allocated until the arena is reset.
+ *
+ * @param arena The arena the block belongs to.
+ * @param ptr The block to give back.
+ */
+void arena_free(Arena *arena, const void *ptr) {
+    if (ptr != NULL && ptr == arena->last) {
+        arena->current->used = (size_t)((const char *)ptr - CHUNK_PAYLOAD(arena->current));
+        arena->last = NULL;
+    }
+}
+
+/**
+ * Title: Arena Reset
+ *
+ * Purpose:
+ * Releases every block of the arena at once. All chunks except the oldest standard-size
+ * chunk are returned to the system; the remaining chunk is emptied for reuse.
+ *
+ * @param arena The arena to reset.
+ */
+void arena_reset(Arena *arena) {
+    Arena_chunk *current = arena->current;
+    Arena_chunk *temp;
+
+    while (current != NULL && current->next_chunk != NULL) {
+        temp = current;
+        current = current->next_chunk;
+        free(temp);
+    }
+    if (current != NULL && current->size != ARENA_CHUNK_SIZE) {
+        free(current);  /* Dedicated chunks are not worth keeping around.*/
+        current = NULL;
+    }
+    if (current != NULL) {
+        current->used = 0;
+    }
+    arena->current = current;
+    arena->last = NULL;
+}
+
+/**
+ * Title: Arena Release
+ *
+ * Purpose:
+ * Returns every chunk of the arena to the system, leaving an empty arena.
+ *
+ * @param arena The arena to release.
+ */
+void arena_release(Arena *arena) {
+    arena_reset(arena);
+    free(arena->current);
+    arena->current = NULL;
+}
+
+#if !defined(__GNUC__)
+/**
+ * Title: Create Arena Key
+ *
+ * Purpose:
+ * Creates the thread-specific key holding each thread's bound arena. Run once.
  */
+static void create_arena_key(void) {
+    pthread_key_create(&arena_key, NULL);
+}
+#endif
+
+/**
+ * Title: Bind Arena
+ *
+ * Purpose:
+ * Makes `safe_alloc` and friends use `arena` for the calling thread. Threads that
+ * never bind an arena share the global one.
+ *
+ * @param arena The arena to allocate from, or NULL for the global arena.
+ */
+void bind_arena(Arena *arena) {
+#if defined(__GNUC__)
+    bound_arena = arena;
+#else
+    pthread_once(&arena_key_once, create_arena_key);
+    pthread_setspecific(arena_key, arena);
+#endif
+}
+
+/**
+ * Title: Current Arena
+ *
+ * Purpose:
+ * Finds the arena the calling thread allocates from. It is on the path of every
+ * allocation, so with GCC and Clang it is a single thread-local load.
+ *
+ * @return Arena* The arena bound to the thread, or the global arena.
+ */
+static Arena *current_arena(void) {
+#if defined(__GNUC__)
+    Arena *arena = bound_arena;
+#else
+    Arena *arena;
+    pthread_once(&arena_key_once, create_arena_key);
+    arena = pthread_getspecific(arena_key);
+#endif
+    return arena != NULL ? arena : &global_arena;
+}
 
 /**
  * Title: Safe Memory Allocation
  *
  * Purpose:
- * This function allocates memory for the specified size and tracks the pointer in a linked list.
- * If the allocation fails, it prints an error message, frees any already allocated memory,
- * and terminates the program.
+ * This function allocates memory for the specified size from the calling thread's arena.
+ * If the allocation fails, it prints an error message and unwinds to the arena's recovery
+ * point, so that only the assembly owning the arena fails. Arenas without a recovery point
+ * free any already allocated memory and terminate the program.
  *
  * @param size The size of memory to allocate.
  * @return void* A pointer to the allocated memory block.
- * @exit If memory allocation fails, the program is terminated with `exit(EXIT_FAILURE)`.
+ * @exit If memory allocation fails and the arena has no recovery point, the program is
+ *       terminated with `exit(EXIT_FAILURE)`.
  */
 void *safe_alloc(const size_t size) {
-    Memory_node *new_node;
-    void *ptr = malloc(size);
+    Arena *arena = current_arena();
+    void *ptr = arena_alloc(arena, size);
 
-    /* If malloc fails to allocate memory, print error, clean up and exit.*/
+    /* If the arena fails to get a new chunk, print error, then recover or clean up and exit.*/
     if (ptr == NULL) {
-        MEM_ALOC_ERROR();  /* Error handling function (assumed to print an error message) */
-        free_all_memory();
-        exit(EXIT_FAILURE);
-    }
-
-    /* Allocate memory to track this block in the linked list.*/
-    new_node = (Memory_node *)malloc(sizeof(Memory_node));
-
-    /* If malloc fails to allocate memory for the node, handle error and exit.*/
-    if (new_node == NULL) {
         MEM_ALOC_ERROR();
-        free(ptr);
+        if (arena->on_failure != NULL) {
+            longjmp(*arena->on_failure, 1);
+        }
         free_all_memory();
         exit(EXIT_FAILURE);
     }
+    return ptr;  /* Return the allocated memory pointer */
+}
 
-    /* Track the allocated memory in the linked list.*/
-    new_node->ptr = ptr;
-    new_node->next_node = head;
-    head = new_node;
+/**
+ * Title: Safe Memory Reallocation
+ *
+ * Purpose:
+ * Grows a block allocated with `safe_alloc`. If the block is the most recent allocation
+ * and the current chunk has room, it is extended in place without copying.
+ *
+ * @param ptr The block to grow.
+ * @param old_size The current size of the block.
+ * @param new_size The requested size of the block.
+ * @return void* A pointer to the grown block.
+ */
+void *safe_realloc(void *ptr, const size_t old_size, const size_t new_size) {
+    Arena *arena = current_arena();
+    Arena_chunk *chunk = arena->current;
+    void *new_ptr;
 
-    return ptr;  /* Return the allocated memory pointer */
+    if (ptr != NULL && ptr == arena->last) {
+        const size_t offset = (size_t)((char *)ptr - CHUNK_PAYLOAD(chunk));
+        if (chunk->size - offset >= ALIGN_UP(new_size)) {
+            chunk->used = offset + ALIGN_UP(new_size);  /* Extend in place.*/
+            return ptr;
+        }
+    }
+    new_ptr = safe_alloc(new_size);
+    if (ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return new_ptr;
 }
 
 /**
  * Title: Free Memory Pointer
  *
  * Purpose:
- * This function frees a specific memory block, given its pointer, and removes it from the tracking list.
- * If the pointer is not found in the list, it does nothing.
+ * This function gives a specific memory block back to the arena. The block is reclaimed
+ * immediately only if it is the most recent allocation; otherwise it is reclaimed by the
+ * next call to `free_all_memory`.
  *
  * @param ptr The pointer to the memory block to free.
  */
 void free_ptr(const void *ptr) {
-    Memory_node *current = head;
-    Memory_node *prev = NULL;
-
-    /* Traverse the linked list to find the memory node that holds the specified pointer.*/
-    while (current != NULL) {
-        if (current->ptr == ptr) {  /* If the pointer matches Remove the node from the list*/
-            if (prev == NULL) {
-                head = current->next_node;  /* Remove from the head of the list.*/
-            } else {
-                prev->next_node = current->next_node;  /* Skip the current node.*/
-            }
-            free(current->ptr);  /* Free the allocated memory*/
-            free(current);  /* Free the node that tracked this memory block*/
-            return;  /* Memory successfully freed, exit the function.*/
-        }
-        prev = current;
-        current = current->next_node;
-    }
+    arena_free(current_arena(), ptr);
 }
 
 /**
  * Title: Free All Allocated Memory
  *
  * Purpose:
- * This function frees all the memory blocks that were allocated using `safe_alloc`,
- * as tracked by the linked list. After freeing the memory, it resets the list to NULL.
+ * This function frees all the memory blocks that were allocated using `safe_alloc`
+ * by resetting the calling thread's arena. The cost depends on the number of chunks, not on
+ * the number of blocks that were handed out.
  */
 void free_all_memory() {
-    Memory_node *current = head;
-    Memory_node *temp;
-
-    /* Traverse the list, freeing all memory blocks and their tracking nodes.*/
-    while (current != NULL) {
-        temp = current;
-        current = current->next_node;
-        free(temp->ptr);  /* Free the actual allocated memory block*/
-        free(temp);  /* Free the node tracking this memory*/
-    }
-    head = NULL;  /* Reset the linked list to indicate all memory is freed.*/
-}
\ No newline at end of file
+    arena_reset(current_arena());
+}
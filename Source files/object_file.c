@@ -0,0 +1,176 @@
+#include "object_file.h"
+#include "output.h"
+#include "file_extensions.h"
+#include <string.h>
+
+/*
+ * Purpose:
+ * This file implements the binary object file (.obb). The whole file is laid out in
+ * one buffer, sized from the header, and written with write_output_file, so like the
+ * textual output files it is written in one call and renamed into place.
+ *
+ * Key Functions:
+ * - `locate_object_sections`: Computes where the sections of a .obb file start.
+ * - `create_binary_object_file`: Writes the result of a context to its .obb file.
+ */
+
+#define BYTE_ORDER_MARK 0x01020304U /* Reads back differently on a machine of another byte order */
+
+/**
+ * Function: align_section
+ * Purpose: Rounds a section size up to the section alignment.
+ *
+ * Parameters:
+ *   - size: The number of bytes in the section.
+ *
+ * Returns:
+ *   - The number of bytes the section takes in the file.
+ */
+static size_t align_section(const size_t size) {
+  return (size + OBJECT_FILE_ALIGNMENT - 1) / OBJECT_FILE_ALIGNMENT * OBJECT_FILE_ALIGNMENT;
+}
+
+/**
+ * Function: locate_object_sections
+ * Purpose: Computes where the sections of a .obb file start from the counts in its header.
+ *
+ * Parameters:
+ *   - header: The header of the file.
+ *   - at: Output: the offset of each section and the size of the file.
+ */
+void locate_object_sections(const object_file_header *header, object_file_sections *at) {
+  at->code = align_section(sizeof(object_file_header));
+  at->data = at->code + align_section((size_t)header->code_size * OBJECT_WORD_BYTES);
+  at->entries = at->data + align_section((size_t)header->data_size * OBJECT_WORD_BYTES);
+  at->externals = at->entries + (size_t)header->entry_count * sizeof(object_file_symbol);
+  at->relocations = at->externals + (size_t)header->extern_count * sizeof(object_file_symbol);
+  at->names = at->relocations + (size_t)header->relocation_count * sizeof(unsigned int);
+  at->end = at->names + align_section(header->names_length);
+}
+
+/**
+ * Function: pack_words
+ * Purpose: Stores words in 3 bytes each, least significant byte first.
+ *
+ * Parameters:
+ *   - out: The section.
+ *   - words: The words.
+ *   - count: The number of words.
+ */
+static void pack_words(unsigned char *out, const unsigned long *words, const int count) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    *out++ = (unsigned char)(words[i] & 0xFF);
+    *out++ = (unsigned char)((words[i] >> 8) & 0xFF);
+    *out++ = (unsigned char)((words[i] >> 16) & 0xFF);
+  }
+}
+
+/**
+ * Function: names_length
+ * Purpose: Counts the characters of the names section.
+ *
+ * Parameters:
+ *   - symbols: The entries or the external references.
+ *   - count: The number of symbols.
+ *
+ * Returns:
+ *   - The number of characters of their names, each with its '\0'.
+ */
+static size_t names_length(const assembler_symbol *symbols, const int count) {
+  size_t length = 0;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    length += strlen(symbols[i].name) + 1;
+  }
+  return length;
+}
+
+/**
+ * Function: put_symbols
+ * Purpose: Stores a symbol table and appends the names of its symbols to the names section.
+ *
+ * Parameters:
+ *   - out: The symbol table section.
+ *   - symbols: The entries or the external references.
+ *   - count: The number of symbols.
+ *   - names: The names section.
+ *   - offset: The number of characters already in the names section.
+ *
+ * Returns:
+ *   - The number of characters in the names section afterwards.
+ */
+static size_t put_symbols(object_file_symbol *out, const assembler_symbol *symbols,
+                          const int count, char *names, size_t offset) {
+  size_t length;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    length = strlen(symbols[i].name) + 1;
+    memcpy(names + offset, symbols[i].name, length);
+    out[i].name = (unsigned int)offset;
+    out[i].address = (unsigned int)symbols[i].address;
+    offset += length;
+  }
+  return offset;
+}
+
+/**
+ * Function: create_binary_object_file
+ * Purpose: Writes the result of an assembly to the context's .obb file.
+ *
+ * Parameters:
+ *   - ctx: The assembler context of the file, after the second pass.
+ *
+ * Returns:
+ *   - NORMAL on success, ERROR if the file could not be written.
+ */
+enum errors create_binary_object_file(assembler_ctx *ctx) {
+  const assembler_result *result = &ctx->result;
+  char *file_name = add_extension(ctx->file_name, BINARY_OBJECT_FILE_EXT);
+  object_file_header header;
+  object_file_sections at;
+  unsigned int *relocations;
+  unsigned char *file;
+  size_t names;
+  int i, written;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, OBJECT_FILE_MAGIC, sizeof(header.magic));
+  header.version = OBJECT_FILE_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.start_address = START_ADDRESS;
+  header.code_size = (unsigned int)result->code_size;
+  header.data_size = (unsigned int)result->data_size;
+  header.entry_count = (unsigned int)result->entry_count;
+  header.extern_count = (unsigned int)result->extern_count;
+  header.relocation_count = (unsigned int)result->relocation_count;
+  header.names_length = (unsigned int)(names_length(result->entries, result->entry_count) +
+                                       names_length(result->externals, result->extern_count));
+  locate_object_sections(&header, &at);
+
+  file = safe_alloc(at.end);
+  memset(file, 0, at.end); /* the padding */
+  memcpy(file, &header, sizeof(header));
+  pack_words(file + at.code, result->words, result->code_size);
+  pack_words(file + at.data, result->words + result->code_size, result->data_size);
+  names = put_symbols((object_file_symbol *)(file + at.entries), result->entries,
+                      result->entry_count, (char *)file + at.names, 0);
+  put_symbols((object_file_symbol *)(file + at.externals), result->externals,
+              result->extern_count, (char *)file + at.names, names);
+  relocations = (unsigned int *)(file + at.relocations);
+  for (i = 0; i < result->relocation_count; i++) {
+    relocations[i] = (unsigned int)result->relocations[i];
+  }
+
+  written = write_output_file(file_name, (const char *)file, at.end);
+  free_ptr(file);
+  free_ptr(file_name);
+  if (!written) {
+    FILE_OPEN_ERROR();
+    return ERROR;
+  }
+  return NORMAL;
+}
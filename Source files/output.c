@@ -0,0 +1,243 @@
+#define _POSIX_C_SOURCE 200112L /* for open and write */
+#include "output.h"
+#include "input.h"
+#include "memory_utility.h"
+#include "file_extensions.h"
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+/*
+ * Purpose:
+ * This file implements the output layer of the assembler. The output files are
+ * formatted into a single buffer with the fixed-width encoders below, which copy
+ * two characters per table lookup instead of interpreting a format string for
+ * every word, and each file is then written with one write() call. Files are
+ * written under a temporary name of their own and renamed into place, so a
+ * reader sees either the old file or the complete new one, even when two
+ * assemblies write the same file at once. The files are not synced: rename
+ * already makes the replacement atomic, and durability across a crash is left
+ * to the system, as with any build output.
+ *
+ * Key Functions:
+ * - `decimal_length`: Counts the characters of a formatted number.
+ * - `put_decimal`: Formats a number in decimal, padded to a minimum width.
+ * - `put_hex_word`: Formats a memory word as 6 hexadecimal digits.
+ * - `write_output_file`: Writes a formatted file in one call.
+ */
+
+#define OUTPUT_FILE_MODE 0666 /* As for fopen; the umask applies */
+#define TEMP_NAME_ATTEMPTS 100 /* Names tried before giving up on a temporary file */
+
+/* The two decimal digits of each number from 0 to 99 */
+static const char decimal_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* The two hexadecimal digits of each byte */
+static const char hex_pairs[256][2] = {
+    "00", "01", "02", "03", "04", "05", "06", "07",
+    "08", "09", "0a", "0b", "0c", "0d", "0e", "0f",
+    "10", "11", "12", "13", "14", "15", "16", "17",
+    "18", "19", "1a", "1b", "1c", "1d", "1e", "1f",
+    "20", "21", "22", "23", "24", "25", "26", "27",
+    "28", "29", "2a", "2b", "2c", "2d", "2e", "2f",
+    "30", "31", "32", "33", "34", "35", "36", "37",
+    "38", "39", "3a", "3b", "3c", "3d", "3e", "3f",
+    "40", "41", "42", "43", "44", "45", "46", "47",
+    "48", "49", "4a", "4b", "4c", "4d", "4e", "4f",
+    "50", "51", "52", "53", "54", "55", "56", "57",
+    "58", "59", "5a", "5b", "5c", "5d", "5e", "5f",
+    "60", "61", "62", "63", "64", "65", "66", "67",
+    "68", "69", "6a", "6b", "6c", "6d", "6e", "6f",
+    "70", "71", "72", "73", "74", "75", "76", "77",
+    "78", "79", "7a", "7b", "7c", "7d", "7e", "7f",
+    "80", "81", "82", "83", "84", "85", "86", "87",
+    "88", "89", "8a", "8b", "8c", "8d", "8e", "8f",
+    "90", "91", "92", "93", "94", "95", "96", "97",
+    "98", "99", "9a", "9b", "9c", "9d", "9e", "9f",
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
+    "a8", "a9", "aa", "ab", "ac", "ad", "ae", "af",
+    "b0", "b1", "b2", "b3", "b4", "b5", "b6", "b7",
+    "b8", "b9", "ba", "bb", "bc", "bd", "be", "bf",
+    "c0", "c1", "c2", "c3", "c4", "c5", "c6", "c7",
+    "c8", "c9", "ca", "cb", "cc", "cd", "ce", "cf",
+    "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7",
+    "d8", "d9", "da", "db", "dc", "dd", "de", "df",
+    "e0", "e1", "e2", "e3", "e4", "e5", "e6", "e7",
+    "e8", "e9", "ea", "eb", "ec", "ed", "ee", "ef",
+    "f0", "f1", "f2", "f3", "f4", "f5", "f6", "f7",
+    "f8", "f9", "fa", "fb", "fc", "fd", "fe", "ff"
+};
+
+/**
+ * Function: decimal_length
+ * Purpose: Counts the characters put_decimal writes for a number and a width.
+ *
+ * Parameters:
+ *   - value: The number.
+ *   - width: The minimum number of characters.
+ *
+ * Returns:
+ *   - The larger of the number of digits of the value and the width.
+ */
+size_t decimal_length(unsigned long value, const int width) {
+  int count = 1;
+
+  while (value >= 10) {
+    value /= 10;
+    count++;
+  }
+  return (size_t)(count < width ? width : count);
+}
+
+/**
+ * Function: put_decimal
+ * Purpose: Formats a non-negative number in decimal, two digits per table lookup.
+ *
+ * Parameters:
+ *   - out: Where to write the characters.
+ *   - value: The number.
+ *   - width: The minimum number of characters, as in "%07d" or "%7d".
+ *   - pad: The character padding the number to the width, '0' or ' '.
+ *
+ * Returns:
+ *   - The number of characters written.
+ */
+size_t put_decimal(char *out, unsigned long value, const int width, const char pad) {
+  char digits[MAX_DECIMAL_DIGITS];
+  int count = 0, length;
+
+  while (value >= 100) {
+    count += 2;
+    digits[sizeof(digits) - count] = decimal_pairs[2 * (value % 100)];
+    digits[sizeof(digits) - count + 1] = decimal_pairs[2 * (value % 100) + 1];
+    value /= 100;
+  }
+  if (value >= 10) {
+    count += 2;
+    digits[sizeof(digits) - count] = decimal_pairs[2 * value];
+    digits[sizeof(digits) - count + 1] = decimal_pairs[2 * value + 1];
+  } else {
+    digits[sizeof(digits) - ++count] = (char)('0' + value);
+  }
+
+  length = count < width ? width : count;
+  memset(out, pad, (size_t)(length - count));
+  memcpy(out + length - count, digits + sizeof(digits) - count, (size_t)count);
+  return (size_t)length;
+}
+
+/**
+ * Function: put_hex_word
+ * Purpose: Formats a memory word as exactly 6 lowercase hexadecimal digits, as "%06lx" does
+ * for a 24-bit value.
+ *
+ * Parameters:
+ *   - out: Where to write the characters.
+ *   - word: The word; only its low 24 bits are formatted.
+ *
+ * Returns:
+ *   - The number of characters written, HEX_WORD_DIGITS.
+ */
+size_t put_hex_word(char *out, const unsigned long word) {
+  const char *high = hex_pairs[(word >> 16) & 0xFF];
+  const char *middle = hex_pairs[(word >> 8) & 0xFF];
+  const char *low = hex_pairs[word & 0xFF];
+
+  out[0] = high[0];
+  out[1] = high[1];
+  out[2] = middle[0];
+  out[3] = middle[1];
+  out[4] = low[0];
+  out[5] = low[1];
+  return HEX_WORD_DIGITS;
+}
+
+/**
+ * Function: create_temp_file
+ * Purpose: Creates a temporary file next to a file, under a name no one else is using.
+ *
+ * The name is the file's name followed by the process id, a tag and TEMP_FILE_EXT. The
+ * tag starts from the address of the name, which no other thread of the process holds
+ * at the same time; the file is created with O_EXCL, and a name that is taken, e.g. by
+ * a process that crashed, is skipped. Unlike mkstemp, the file gets the mode fopen
+ * would give it.
+ *
+ * Parameters:
+ *   - file_name: The name of the file.
+ *   - temp_name: Output: the name of the temporary file, to be freed with free_ptr.
+ *
+ * Returns:
+ *   - The descriptor of the temporary file, or -1 if it could not be created.
+ */
+static int create_temp_file(const char *file_name, char **temp_name) {
+  char *name = safe_alloc(strlen(file_name) + 2 * MAX_DECIMAL_DIGITS + 3 + sizeof(TEMP_FILE_EXT));
+  const unsigned long tag = (unsigned long)(size_t)name;
+  int attempt, fd = -1;
+
+  for (attempt = 0; fd < 0 && attempt < TEMP_NAME_ATTEMPTS; attempt++) {
+    sprintf(name, "%s.%lu.%lu%s", file_name, (unsigned long)getpid(), tag + (unsigned long)attempt,
+            TEMP_FILE_EXT);
+    fd = open(name, O_WRONLY | O_CREAT | O_EXCL, OUTPUT_FILE_MODE);
+    if (fd < 0 && errno != EEXIST) {
+      break;
+    }
+  }
+  *temp_name = name;
+  return fd;
+}
+
+/**
+ * Function: write_output_file
+ * Purpose: Writes a formatted text to a file, replacing it atomically.
+ *
+ * The text goes out in a single write() call to a temporary file of its own; the loop
+ * only continues a write that the system cut short. The temporary file is then renamed
+ * over the file, or removed if anything failed.
+ *
+ * Parameters:
+ *   - file_name: The name of the file.
+ *   - text: The contents of the file.
+ *   - length: The number of characters in the text.
+ *
+ * Returns:
+ *   - 1 on success, 0 if the file could not be created or written.
+ */
+int write_output_file(const char *file_name, const char *text, size_t length) {
+  char *temp_name;
+  int fd = create_temp_file(file_name, &temp_name);
+  int written = fd >= 0;
+  ssize_t count;
+
+  while (written && length > 0) {
+    count = write(fd, text, length);
+    if (count < 0) {
+      written = 0;
+    } else {
+      text += count;
+      length -= (size_t)count;
+    }
+  }
+  if (fd >= 0 && close(fd) != 0) {
+    written = 0;
+  }
+  if (written && rename(temp_name, file_name) != 0) {
+    written = 0;
+  }
+  if (!written && fd >= 0) {
+    unlink(temp_name);
+  }
+  free_ptr(temp_name);
+  return written;
+}
@@ -1,5 +1,4 @@
 #include "const_tables.h"
-#include <ctype.h>
 #include "errors.h"
 #include "handle_text.h"
 #include "memory_utility.h"
@@ -9,7 +8,6 @@
 #include "utility.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
 /*
  * Array of instructions supported by the assembler.
@@ -29,76 +27,49 @@ instruction instructions[] = {
  * or extern label, and handles errors related to invalid input.
  *
  * Key Functions:
- * - `is_instruction`: Checks if a line starts with a valid assembler instruction.
- * - `is_whitespace`: Checks if the line is empty or contains only whitespace.
- * - `is_comment`: Checks if the line is a comment.
- * - `valid_label_char`: Checks if a character is valid for labels.
- * - `is_label`: Checks if a line starts with a valid label.
  * - `parse_string`: Parses a string enclosed in quotation marks.
  * - `parse_linking_instruction`: Parses an extern label (linking label) from the line.
- */
-
-/**
- * Title: Valid Label Character Check
- *
- * Purpose:
- * This helper function checks if a character is valid for use in a label. Labels can only
- * contain alphanumeric characters, the label definition character, or an underscore ('_').
- * It also ensures the label does not exceed the maximum allowed length.
- *
- * @param work_line The current character in the line to check.
- * @param label_length The current length of the label being built.
+ * - `parse_operation`: Parses an operation and its operands.
  *
- * @return int Returns 1 if the character is valid for use in a label, 0 otherwise.
+ * Every function works on the tokens of the line and hands strings out as views into the
+ * line or as interned names, so nothing is copied out of a line to be parsed.
  */
-int valid_label_char(char *work_line, int label_length) {
-  return !isspace(*work_line) &&
-         (isalnum(*work_line) || *work_line == LABEL_DEF_CHAR || *work_line == '_') &&
-         label_length <= MAX_LABEL_LENGTH;
-}
 
 /**
  * Title: String Parsing
  *
  * Purpose:
- * This function extracts a string enclosed in quotation marks from a line. It checks for
+ * This function takes a string enclosed in quotation marks from a line. It checks for
  * proper formatting (like matching quotation marks) and handles errors for malformed strings.
+ * A string that is not closed runs to the end of the line.
  *
- * @param line The line containing the string to extract.
+ * @param line The tokens of the line containing the string to extract.
+ * @param length Output: the number of characters in the string.
  * @param line_number The line number for error reporting.
  * @param status Pointer to the status of the parsing process (either success or error).
  *
- * @return char* Returns the extracted string if successful, or NULL if there is an error.
+ * @return const char* Returns a view of the string in the line if successful, or NULL if there is an error.
  */
-char *parse_string(char *line, int line_number, enum errors *status) {
-  char *work_line = line;
-  while (isspace(*work_line)) {
-    work_line++;
-  }
-  if (*work_line == '\0') {
+const char *parse_string(const token_cursor *line, size_t *length, int line_number,
+                         enum errors *status) {
+  const token *str = peek_token(line);
+  const char *text;
+  if (str == NULL) {
     MISSING_INSTRUCTION_PARAM(line_number);
     *status = ERROR;
     return NULL;
   }
-  if (*work_line == STR_INDICATOR) {
-    char *orig_str, *str = safe_alloc(strlen(work_line) * sizeof(char) + 1);
-    orig_str = str;
-    work_line++;
-    while (*work_line != '\0') {
-      if (*work_line != STR_INDICATOR) {
-        *str++ = *work_line++;
-      } else {
-        work_line++;
-        break;
-      }
+  if (str->kind == TOKEN_STRING) {
+    if (line->position + 1 < line->count) {
+      EXTRA_CHARS_STRING_ERROR(line_number);
+      return NULL;
     }
-    if (*work_line == '\0' || is_whitespace(work_line)) {
-      *str = '\0';
-      return orig_str;
+    text = line->text + str->offset;
+    *length = str->length - 1;
+    if (*length > 0 && text[*length] == STR_INDICATOR) {
+      (*length)--; /* the closing quotation mark */
     }
-    free_ptr(orig_str);
-    EXTRA_CHARS_STRING_ERROR(line_number);
-    return NULL;
+    return text + 1;
   }
   MISSING_STRING_INDICATOR(line_number);
   return NULL;
@@ -109,50 +80,45 @@ char *parse_string(char *line, int line_number, enum errors *status) {
  *
  * Purpose:
  * This function parses a linking label (extern label) from the line. The label is expected to
- * be alphanumeric, and the function checks for any extra characters or malformed input.
+ * be an identifier starting with a letter, and the function checks for any extra characters or
+ * malformed input.
  *
- * @param line The line containing the extern label to extract.
+ * @param line The tokens of the line containing the extern label to extract.
  * @param line_number The line number for error handling.
  * @param status Pointer to the status of the parsing process (either success or error).
  *
- * @return char* Returns the linking label if found, or NULL if there is an error.
+ * @return unsigned int Returns the interned linking label if found, or NO_SYMBOL if there is an error.
  */
-char *parse_linking_instruction(char *line, int line_number, enum errors *status) {
-  char *work_line = line;
-  while (isspace(*work_line)) {
-    work_line++;
-  }
-  if (*work_line == '\0' || is_whitespace(work_line)) {
+unsigned int parse_linking_instruction(const token_cursor *line, int line_number, enum errors *status) {
+  const token *name = peek_token(line);
+  if (name == NULL) {
     MISSING_INSTRUCTION_PARAM(line_number);
     *status = ERROR;
-    return NULL;
+    return NO_SYMBOL;
   }
-  if (isalpha(*work_line)) {
-    char *orig_str, *str = safe_alloc(strlen(work_line) * sizeof(char) + 1);
-    orig_str = str;
-    for (; *work_line != '\0' && !isspace(*work_line) && (isalnum(*work_line) || *work_line == '_');
-         work_line++) {
-      *str++ = *work_line;
-    }
-    if (*work_line == '\0' || is_whitespace(work_line)) {
-      *str = '\0';
-      if (strlen(orig_str) > 31) {
+  if (name->kind == TOKEN_IDENTIFIER && CHAR_IS(line->text[name->offset], CHAR_LETTER)) {
+    if (line->position + 1 == line->count) {
+      if (name->length > 31) {
         LABEL_TOO_LONG(line_number);
       }
-      return orig_str;
+      return name->symbol;
     }
     EXTRA_CHARS_LINKING_ERROR(line_number);
-    return NULL;
+    return NO_SYMBOL;
   }
-  return NULL;
+  return NO_SYMBOL;
 }
 
 /*
  * Function: parse_operation
  * Purpose: Parses an operation line to extract the operation type and its operands.
  *
+ * The operation name is the first word of the line. The source operand runs up to
+ * the first whitespace or comma, and the destination operand up to the next whitespace;
+ * a single operand takes the rest of the line.
+ *
  * Parameters:
- *   work_line - The line to parse.
+ *   line - The tokens of the line, positioned at the operation name.
  *   line_number - The current line number in the source file.
  *   temp - The temporary memory word array to store parsed data.
  *   errors - The current error status.
@@ -160,85 +126,80 @@ char *parse_linking_instruction(char *line, int line_number, enum errors *status
  *   dest_label - Pointer to store the destination operand label.
  *
  * Returns:
- *   - The number of words parsed.
+ *   - The number of words parsed, or 0 if the line has an error, so that IC does not
+ *     move back over words that are already written.
  */
-int parse_operation(char **work_line, int line_number,
+int parse_operation(token_cursor *line, int line_number,
                     memory_word temp[MAX_OPERATION_LEN], enum errors *errors,
-                    char **source_label, char **dest_label) {
+                    unsigned int *source_label, unsigned int *dest_label) {
   /* this should parse the entire line, finding the operation and its operands*/
-  int i;
+  int end;
   int relative;
   operation_syntax syntax;
-  char *param1, *param2;
+  const operation_syntax *found;
+  int param1, param1_end, param2;
   int relative1, relative2;
   int word_count = 1;
-  char *line = *work_line;
-  char *copy = safe_alloc(strlen(*work_line) + 1);
-  IGNORE_WHITESPACE(line);
-  i = 0;
-  while (1) {
-    if (isspace(*line) || *line == '\0') {
-      copy[i] = '\0';
-      break;
-    }
-    copy[i] = *line;
-    i++;
-    line++;
+  const char *name = line->text;
+  int name_length = 0;
+  *source_label = NO_SYMBOL;
+  *dest_label = NO_SYMBOL;
+  if (line->position < line->count) {
+    end = run_end(line, line->position);
+    name += line->tokens[line->position].offset;
+    name_length = (int)(line->tokens[end - 1].offset + line->tokens[end - 1].length -
+                        line->tokens[line->position].offset);
+    line->position = end;
   }
-  syntax = find_operation(copy);
+  if ((found = find_operation(name, name_length)) == NULL) {
+    NON_EXISTANT_NAME(name_length, name); /* Report a non-existent operation */
+    *errors = ERROR;
+    found = &no_operation;
+  }
+  syntax = *found;
   if (is_empty(syntax.source_type) && is_empty(syntax.destination_type)) {
     if (handle_no_operand_operation(temp, source_label, dest_label, line,
                                     syntax, &word_count) == 1)
       return word_count; /* todo error handling*/
   } else if (is_empty(syntax.source_type)) {
-    /*one operand of a type from dest_type from found syntax, line should be the operand with spaces*/
-    IGNORE_WHITESPACE(line);
-    if (*line == '\0') {
+    /*one operand of a type from dest_type from found syntax, the rest of the line is the operand*/
+    if (is_whitespace(line)) {
       MISSING_OPERAND(line_number);
-      return -1;
+      *errors = ERROR;
+      return 0;
     }
     relative = 0;
     temp->operation.opcode = syntax.opcode;
     temp->operation.funct = syntax.funct;
-    word_count += extract_operand(line, temp, dest_label, 1, DEST, &relative);
+    word_count += extract_operand(line, line->position, line->count, temp, dest_label, 1, DEST,
+                                  &relative);
   } else if (!is_empty(syntax.destination_type) &&
              !is_empty(syntax.source_type)) {
     temp->operation.opcode = syntax.opcode;
     temp->operation.funct = syntax.funct;
-    param1 = safe_alloc(strlen(*work_line) + 1);
-    param2 = safe_alloc(strlen(*work_line) + 1);
-    IGNORE_WHITESPACE(line);
-    for (i = 0; *line != '\0'; line++) {
-      if (isspace(*line) || *line == OPERAND_SEPARATOR) {
+    /* the source operand ends at the first whitespace or comma */
+    param1 = line->position;
+    end = param1 < line->count ? run_end(line, param1) : param1;
+    for (param1_end = param1; param1_end < end; param1_end++) {
+      if (line->tokens[param1_end].kind == TOKEN_COMMA) {
         break;
       }
-      param1[i] = *line;
-      i++;
     }
-    param1[i] = '\0';
-    IGNORE_WHITESPACE(line);
-    if (*line != OPERAND_SEPARATOR) {
+    if (param1_end == line->count || line->tokens[param1_end].kind != TOKEN_COMMA) {
       MISSING_COMMA(line_number);
-      return -1;
+      *errors = ERROR;
+      return 0;
     }
-    line++;
-    IGNORE_WHITESPACE(line);
-    if (*line == '\0') {
+    param2 = param1_end + 1;
+    if (param2 == line->count) {
       MISSING_OPERAND(line_number);
-      return -1;
+      *errors = ERROR;
+      return 0;
     }
-    for (i = 0; *line != '\0'; line++) {
-      if (isspace(*line)) {
-        break;
-      }
-      param2[i] = *line;
-      i++;
-    }
-    param2[i] = '\0';
     word_count +=
-        extract_operand(param1, temp, source_label, 1, SOURCE, &relative1);
+        extract_operand(line, param1, param1_end, temp, source_label, 1, SOURCE, &relative1);
     word_count +=
-        extract_operand(param2, temp, dest_label, 2, DEST, &relative2);
+        extract_operand(line, param2, run_end(line, param2), temp, dest_label, 2, DEST, &relative2);
   }
   return word_count;
-}
\ No newline at end of file
+}
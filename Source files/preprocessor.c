@@ -1,19 +1,18 @@
 #include "preprocessor.h"
+#include "assembler.h"
 #include "input.h"
 #include "parsing.h"
 #include "first_pass.h"
 #include "const_tables.h"
 #include "memory_utility.h"
 #include "file_extensions.h"
-#include <ctype.h>
+#include "interner.h"
+#include "lexer.h"
+#include "token_file.h"
+#include "output.h"
 #include <stdio.h>
 #include <string.h>
 
-#define IGNORE_WHITESPACE(work_line)                                           \
-while (isspace(*work_line)) {                                                \
-work_line++;                                                               \
-}
-
 char *reserved_names[28] = {
     "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
     "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc", "dec", "jmp", "bne",
@@ -22,176 +21,291 @@ char *reserved_names[28] = {
 
 
 /**
- * preprocess - Preprocesses a given file by expanding macros and handling
- * the preprocessor logic.
- * @file_name: The name of the file to preprocess.
+ * lex_source_line - Tokenizes a line of the source onto the end of a stream.
+ * @tokens: The stream to append the tokens to.
+ * @symbols: The interner of the source.
+ * @line: The line.
+ * @length: The number of characters in the line.
+ * @cursor: Output: the tokens of the line, for classify_line.
+ *
+ * Returns: The number of tokens on the line.
+ */
+static int lex_source_line(token_stream *tokens, interner *symbols, const char *line,
+                           size_t length, token_cursor *cursor) {
+    const int count = lex_line(tokens, symbols, line, length);
+
+    cursor->text = line;
+    cursor->tokens = tokens->tokens + tokens->token_count - count;
+    cursor->count = count;
+    cursor->position = 0;
+    cursor->symbols = symbols;
+    return count;
+}
+
+/**
+ * expand_macros - Expands the macros of a source, line by line.
+ * @ctx: The assembler context of the source. Its macro table, expanded
+ * source, token stream and interner are filled in.
+ * @input: The reader handing out the lines of the source.
  *
- * This function reads a file, identifies any macros, and expands them
- * according to the macro definitions. It writes the resulting content
- * to an output file. The output file will contain the code with macros
- * expanded.
+ * This function identifies any macros, and expands them according to the
+ * macro definitions. Every line is tokenized exactly once: the tokens of an
+ * ordinary line go straight into the token stream of the expanded source,
+ * and those of a macro body are kept with the macro and copied into the
+ * stream wherever it is invoked.
  *
- * Returns: A pointer to the macro table (linked list of macros) or NULL if an error occurs.
+ * Returns: NORMAL, or ERROR if a macro definition is malformed.
  */
-Macro_table *preprocess(const char *file_name) {
+static enum errors expand_macros(assembler_ctx *ctx, line_reader *input) {
     enum errors ecode = NORMAL;
-    struct Macro_table *curr_macro, *head_macro;
-    char *input_file, *output_file;
+    Macro_table *table;
+    Macro *curr_macro;
     char *line;
-    FILE *input, *output;
-
-    int macro_idx = -1, line_number = -1;
-    head_macro = safe_alloc(sizeof(struct Macro_table));
-    curr_macro = head_macro;
-
-    head_macro->first_line = NULL;
-    head_macro->macro_name = NULL;
-    head_macro->next_macro = NULL;
+    size_t length;
+    text_buffer *expanded = &ctx->expanded;
+    token_stream *tokens = &ctx->tokens;
+    token_cursor cursor;
+    line_kind kind;
+    line_token first_token;
+    int count;
 
-    input_file = add_extension(file_name, PREPROCESSOR_INPUT_EXT);
-    output_file = add_extension(file_name, PREPROCESSOR_OUTPUT_EXT);
+    int line_number = -1;
 
-    input = fopen(input_file, "r"); /*open input file in 'read' mode*/
-    output = fopen(output_file, "w"); /*open output file in 'write' mode*/
+    init_text_buffer(expanded, input->size); /*expansion is usually about as long as the input*/
+    init_interner(&ctx->symbols, input->size / SOURCE_BYTES_PER_LABEL);
+    table = initialise_macro_table(&ctx->symbols);
+    init_token_stream(tokens, input->size / SOURCE_BYTES_PER_LINE * TOKENS_PER_LINE,
+                      input->size / SOURCE_BYTES_PER_LINE);
 
-    if (output == NULL || input == NULL) {
-        FILE_OPEN_ERROR();
-        free_all_memory();
-        return NULL;
-    }
-
-    line = NULL; /*pointer to a buffer for storing each line read from the file*/
-    while ((line = getLine(input)) != NULL) {
+    line = NULL; /*view of the current line, valid until the reader is closed*/
+    while ((line = next_line(input, &length)) != NULL) {
         line_number++;
-        if ((macro_idx = is_saved_macro(line, head_macro)) != -1) {
-            /*find index of macro in line if line is a macro*/
-            print_macro_contents_to_file(macro_idx, head_macro, output);
+        count = lex_source_line(tokens, &ctx->symbols, line, length, &cursor);
+        kind = classify_line(&cursor, table, &first_token);
+        if (kind == LINE_MACRO_CALL) {
+            /*the line invokes a macro, expand its body in place of the line*/
+            tokens->token_count -= count;
+            print_macro_contents(first_token.macro, expanded, tokens);
             continue;
         }
-        if (mcro_start(line)) {
+        if (kind == LINE_MACRO_START) {
+            curr_macro = safe_alloc(sizeof(Macro));
+            curr_macro->macro_name = NULL;
+            insert_macro_name(&cursor, &first_token, curr_macro, &ecode, line_number);
+            tokens->token_count -= count;
             if (curr_macro->macro_name != NULL) {
-                curr_macro->next_macro = safe_alloc(sizeof(struct Macro_table));
-                curr_macro = curr_macro->next_macro;
-                curr_macro->first_line = NULL;
-                curr_macro->macro_name = NULL;
-                curr_macro->next_macro = NULL;
+                add_macro(table, curr_macro); /*a redefinition keeps the first body*/
             }
-            insert_macro_name(line, curr_macro, &ecode, line_number);
-            free_ptr(line);
-            while ((line = getLine(input)) != NULL) {
+            init_text_buffer(&curr_macro->body, MACRO_BODY_MIN_CAPACITY);
+            init_token_stream(&curr_macro->tokens, MACRO_BODY_MIN_CAPACITY / SOURCE_BYTES_PER_LINE *
+                              TOKENS_PER_LINE, MACRO_BODY_MIN_CAPACITY / SOURCE_BYTES_PER_LINE);
+            while ((line = next_line(input, &length)) != NULL) {
                 line_number++;
-                if (!mcro_end(line, &ecode, line_number)) {
-                    append_line_to_macro(line, curr_macro);
+                count = lex_source_line(&curr_macro->tokens, &ctx->symbols, line, length, &cursor);
+                if (classify_line(&cursor, NULL, &first_token) != LINE_MACRO_END) {
+                    append_line_to_macro(line, length, count, curr_macro);
                 } else {
-                    free_ptr(line);
+                    if (first_token.rest < cursor.count) {
+                        ecode = ERROR;
+                        EXTRA_CHARS_MACRO_ERROR(line_number);
+                    }
+                    curr_macro->tokens.token_count -= count;
                     break;
                 }
             }
         } else {
-            fputs(line, output);
-            fputc('\n', output);
+            add_token_line(tokens, expanded->length, count);
+            line[length] = '\n'; /*append the line together with its newline*/
+            append_text(expanded, line, length + 1);
         }
-        free_ptr(line);
     }
-    fclose(input);
-    fclose(output);
-    return head_macro;
+    ctx->macros = table;
+    return ecode;
 }
 
 /**
- * append_line_to_macro - Adds a line to a macro's content.
- * @line: The line to be added to the macro.
- * @curr_macro: The current macro to append the line to.
+ * preprocess - Preprocesses a given file by expanding macros and handling
+ * the preprocessor logic.
+ * @ctx: The assembler context of the file. Its macro table and expanded
+ * source are filled in.
+ *
+ * This function reads a file and expands its macros. The resulting content
+ * is kept in memory and handed straight to the first pass; the .am file is
+ * only written when requested, for debugging.
  *
- * This function will append a line to the macro's list of lines.
- * If this is the first line of the macro, it will initialize the first line.
+ * When the context uses the .amt file, the source is digested before it is
+ * expanded. If the .amt file was made from the same source, it is loaded in
+ * place of the expansion, so nothing is lexed; otherwise the source is
+ * expanded and, if it has no macro errors, the .amt file is written for the
+ * next run. A source with macro errors never gets one, so its errors are
+ * reported every time it is assembled, and it is not translated.
+ *
+ * Returns: NORMAL on success, or ERROR if the source has macro errors or the source,
+ * .am or .amt file could not be opened.
  */
-void append_line_to_macro(char *line, struct Macro_table *curr_macro) {
-    struct Macro_line *curr_line;
-    if (curr_macro->first_line == NULL) {
-        curr_macro->first_line = safe_alloc(sizeof(struct Macro_line));
-        curr_macro->first_line->line = line;
-        curr_macro->first_line->next_line = NULL;
-        return;
+enum errors preprocess(assembler_ctx *ctx) {
+    char *input_file;
+    line_reader input;
+    unsigned long source_digest[SOURCE_DIGEST_WORDS];
+    enum errors status = NORMAL;
+    int loaded = 0;
+    int written = 1;
+
+    input_file = add_extension(ctx->file_name, PREPROCESSOR_INPUT_EXT);
+
+    if (!open_line_reader(&input, input_file)) { /*map input file for reading*/
+        FILE_OPEN_ERROR();
+        return ERROR;
     }
-    curr_line = curr_macro->first_line;
-    while (curr_line->next_line != NULL) {
-        curr_line = curr_line->next_line;
+    if (ctx->use_token_file) {
+        digest_source(input.data, input.size, source_digest); /*before next_line splits the lines*/
+        loaded = load_token_file(ctx, input.size, source_digest);
     }
-    curr_line->next_line = safe_alloc(sizeof(struct Macro_line));
-    curr_line->next_line->line = line;
-    curr_line->next_line->next_line = NULL;
+    if (!loaded) {
+        status = expand_macros(ctx, &input);
+        if (status == NORMAL && ctx->use_token_file) {
+            written = write_token_file(ctx, input.size, source_digest);
+        }
+    }
+    close_line_reader(&input);
+    if (!written) {
+        FILE_OPEN_ERROR();
+        return ERROR;
+    }
+    if (ctx->emit_am && !write_expanded_file(ctx->file_name, &ctx->expanded)) {
+        FILE_OPEN_ERROR();
+        return ERROR;
+    }
+    return status;
 }
 
 /**
- * print_macro_contents_to_file - Writes the contents of a macro to the output file.
- * @macro_idx: The index of the macro to print.
- * @head_macro: The head of the macro table.
- * @output: The file to write the macro content to.
+ * preprocess_text - Preprocesses source text held in memory.
+ * @ctx: The assembler context of the source.
+ * @source: The source text, which is left unchanged.
+ * @length: The number of characters in the source.
  *
- * This function writes all the lines of a macro to the provided output file.
+ * The source is copied into the context's arena, where the reader may split
+ * it into lines in place, and its macros are expanded as for a file.
+ *
+ * Returns: NORMAL on success, or ERROR if the source has macro errors.
  */
-void print_macro_contents_to_file(const int macro_idx, struct Macro_table *head_macro, FILE *output) {
-    int idx;
-    struct Macro_table *curr_macro = head_macro;
-    struct Macro_line *curr_line;
+enum errors preprocess_text(assembler_ctx *ctx, const char *source, const size_t length) {
+    text_buffer copy;
+    line_reader input;
+    enum errors status;
 
-    for (idx = 0; idx < macro_idx; idx++) {
-        curr_macro = curr_macro->next_macro;
-    }
-    curr_line = curr_macro->first_line;
-    while (curr_line != NULL && curr_line->line != NULL) {
-        fputs(curr_line->line, output);
-        fputc('\n', output);
-        curr_line = curr_line->next_line;
-    }
+    init_text_buffer(&copy, length);
+    append_text(&copy, source, length);
+    open_buffer_reader(&input, &copy);
+    status = expand_macros(ctx, &input);
+    close_line_reader(&input);
+    return status;
 }
 
 /**
- * mcro_start - Checks if a line starts a macro definition.
- * @line: The line to check.
+ * write_expanded_file - Writes the expanded source to the .am file.
+ * @file_name: The name of the source file, without extension.
+ * @expanded: The expanded source.
+ *
+ * The file is written in one call and renamed into place, like the output files.
  *
- * This function checks whether the given line represents the start of a macro.
- * Returns: 1 if the line starts a macro, 0 otherwise.
+ * Returns: 1 on success, 0 if the file could not be written.
  */
-int mcro_start(const char *line) {
-    int i, j;
-    for (i = 0; isspace(*(line + i)) && i < strlen(line); i++) {
-    }
-    for (j = 0; *(line + i + j) == MACRO_START[j] && i < strlen(line) && j < strlen(MACRO_START); j++) {
-    }
-    if (j == strlen(MACRO_START) && isspace(*(line + i + j))) {
-        return 1;
-    }
-    return 0;
+int write_expanded_file(const char *file_name, const text_buffer *expanded) {
+    char *output_file = add_extension(file_name, PREPROCESSOR_OUTPUT_EXT);
+    int written = write_output_file(output_file, expanded->text, expanded->length);
+
+    free_ptr(output_file);
+    return written;
 }
 
 /**
- * mcro_end - Checks if a line ends a macro definition.
- * @line: The line to check.
- * @ecode: The error code pointer for handling errors.
- * @line_number: The current line number being processed.
+ * append_line_to_macro - Adds a line to a macro's content.
+ * @line: The line to be added to the macro.
+ * @length: The number of characters in the line.
+ * @token_count: The number of tokens on the line, the last of the macro's tokens.
+ * @curr_macro: The current macro to append the line to.
  *
- * This function checks whether the given line represents the end of a macro.
- * Returns: 1 if the line ends a macro, 0 otherwise.
+ * This function copies the line, followed by a newline, to the end of the
+ * macro's body, so the body is kept exactly as it will be expanded, and
+ * records where the line and its tokens start.
  */
-int mcro_end(const char *line, enum errors *ecode, const int line_number) {
-    int i, j;
-    for (i = 0; isspace(*(line + i)) && i < strlen(line); i++) {
+void append_line_to_macro(const char *line, size_t length, int token_count, Macro *curr_macro) {
+    add_token_line(&curr_macro->tokens, curr_macro->body.length, token_count);
+    append_text(&curr_macro->body, line, length);
+    append_text(&curr_macro->body, "\n", 1);
+}
+
+/**
+ * print_macro_contents - Writes the contents of a macro to the expanded source.
+ * @macro: The macro to print.
+ * @output: The buffer to append the macro content to.
+ * @tokens: The token stream of the expanded source.
+ *
+ * The body and its tokens are stored pre-joined, so the whole expansion is
+ * a single copy of each; the body is not tokenized again.
+ */
+void print_macro_contents(const Macro *macro, text_buffer *output, token_stream *tokens) {
+    append_token_lines(tokens, &macro->tokens, output->length);
+    append_text(output, macro->body.text, macro->body.length);
+}
+
+/**
+ * classify_line - Classifies a tokenized line by its first word.
+ * @line: The tokens of the line to classify.
+ * @table: The macro table, or NULL to only recognise macro starts and ends.
+ * @word: Output: the first word of the line and what follows it.
+ *
+ * The first word is the run of tokens at the start of the line that are not
+ * separated by whitespace. It starts a macro definition if it is exactly
+ * MACRO_START and followed by whitespace, ends one if it begins with
+ * MACRO_END (anything after MACRO_END is then an error for the caller to
+ * report), and invokes a macro if it is the name of one.
+ *
+ * Returns: The kind of the line.
+ */
+line_kind classify_line(const token_cursor *line, const Macro_table *table, line_token *word) {
+    const size_t start_length = sizeof(MACRO_START) - 1, end_length = sizeof(MACRO_END) - 1;
+    const token *first, *last;
+
+    word->macro = NULL;
+    if (line->count == 0) {
+        word->token = line->text;
+        word->token_length = 0;
+        word->rest = 0;
+        return word->kind = LINE_OTHER;
     }
-    for (j = 0; *(line + i + j) == MACRO_END[j] && i < strlen(line) && j < strlen(MACRO_END); j++) {
+    word->rest = run_end(line, 0);
+    first = &line->tokens[0];
+    last = &line->tokens[word->rest - 1];
+    word->token = line->text + first->offset;
+    word->token_length = last->offset + last->length - first->offset;
+
+    if (table != NULL && table->count > 0) {
+        /*a one-identifier word has its id already, anything else is looked up*/
+        word->macro = find_macro(table, word->rest == 1 && first->kind == TOKEN_IDENTIFIER ?
+                                 first->symbol : find_symbol(line->symbols, word->token,
+                                                             word->token_length));
+        if (word->macro != NULL) {
+            return word->kind = LINE_MACRO_CALL;
+        }
     }
-    for (i = i + j; isspace(*(line + i)) && i < strlen(line); i++) {
+    if (first->kind != TOKEN_IDENTIFIER) {
+        return word->kind = LINE_OTHER;
     }
-    if (j == strlen(MACRO_END)) {
-        if (i == strlen(line)) {
-            return 1;
+    if (word->token_length == start_length && CHAR_IS(word->token[start_length], CHAR_SPACE) &&
+        memcmp(word->token, MACRO_START, start_length) == 0) {
+        return word->kind = LINE_MACRO_START;
+    }
+    if (first->length >= end_length && memcmp(word->token, MACRO_END, end_length) == 0) {
+        /*anything glued to or after MACRO_END is left for the caller to report*/
+        if (word->token_length != end_length) {
+            word->rest = 0;
         }
-        *ecode = ERROR;
-        EXTRA_CHARS_MACRO_ERROR(line_number);
-        return 1;
+        return word->kind = LINE_MACRO_END;
     }
-    return 0;
+    return word->kind = LINE_OTHER;
 }
 
 /**
@@ -202,7 +316,7 @@ int mcro_end(const char *line, enum errors *ecode, const int line_number) {
  * reserved names. Reserved names cannot be used as macro names.
  * Returns: 1 if the name is reserved, 0 otherwise.
  */
-int is_reserved_name(char *mcro_name) {
+int is_reserved_name(const char *mcro_name) {
     int i;
     for (i = 0; i < sizeof(reserved_names)/sizeof(reserved_names[0]); i++) {
         if (strcmp(reserved_names[i], mcro_name) == 0) {
@@ -214,40 +328,43 @@ int is_reserved_name(char *mcro_name) {
 }
 
 /**
- * insert_macro_name - Inserts a new macro name into the macro table.
- * @line: The line containing the macro name.
+ * insert_macro_name - Reads the name of a new macro.
+ * @line: The tokens of the definition line.
+ * @start: The classified definition line (of kind LINE_MACRO_START).
  * @curr_macro: The current macro being processed.
  * @ecode: The error code pointer for handling errors.
  * @line_number: The current line number being processed.
  *
- * This function extracts a macro name from the given line and inserts it
- * into the macro table. If the macro name is reserved, an error is thrown.
+ * This function extracts the macro name, the word following MACRO_START,
+ * and stores its interned id in the macro. A name made of one identifier is
+ * interned already; any other name is interned here. If the macro name is
+ * reserved, an error is thrown; if there is anything after the name, an error
+ * is thrown and no name is stored.
  */
-void insert_macro_name(const char *line, struct Macro_table *curr_macro, enum errors *ecode, int line_number) {
-    int i, j;
-    char *macro_name = safe_alloc(strlen(line)+1);
-    for (i = 0; isspace(*(line + i)) && i < strlen(line); i++) {
-    } /*ignore whitespace*/
-    for (j = 0; *(line + i + j) == MACRO_START[j] && i < strlen(line) && j < strlen(MACRO_START); j++) {
-    }
-    for (i = i + j; isspace(*(line + i)) && i < strlen(line); i++) {
-    } /*ignore whitespace*/
-    j = 0 ;
-    while (isprint(*(line + i)) && !isspace(*(line + i)) && i < strlen(line)+1) {
-        macro_name[j] = line[i];
-        i++;
-        j++;
+void insert_macro_name(const token_cursor *line, const line_token *start, Macro *curr_macro,
+                       enum errors *ecode, int line_number) {
+    const token *first, *last;
+    unsigned int symbol;
+    int end = start->rest;
+
+    if (start->rest == line->count) {
+        symbol = intern(line->symbols, "", 0);
+    } else {
+        end = run_end(line, start->rest);
+        first = &line->tokens[start->rest];
+        last = &line->tokens[end - 1];
+        symbol = end - start->rest == 1 && first->kind == TOKEN_IDENTIFIER ? first->symbol :
+                 intern(line->symbols, line->text + first->offset,
+                        last->offset + last->length - first->offset);
     }
-    macro_name[j] = '\0';
-    if (is_reserved_name(macro_name)) {
-        *ecode = MACRO_NAME_RESERVED(line_number);
+    if (is_reserved_name(symbol_name(line->symbols, symbol))) {
+        *ecode = ERROR;
+        MACRO_NAME_RESERVED(line_number);
     }
 
-    for (; isspace(*(line + i)) && i < strlen(line); i++) {
-    } /*ignore whitespace*/
-
-    if (i == strlen(line)) {
-        curr_macro->macro_name = macro_name;
+    if (end == line->count) {
+        curr_macro->symbol = symbol;
+        curr_macro->macro_name = symbol_name(line->symbols, symbol);
         return;
     }
     *ecode = ERROR;
@@ -255,37 +372,77 @@ void insert_macro_name(const char *line, struct Macro_table *curr_macro, enum er
 }
 
 /**
- * is_saved_macro - Checks if the given line matches any saved macro.
- * @line: The line to check.
- * @head: The head of the macro table.
+ * clear_macro_slots - Marks a range of slots empty.
+ * @slots: The slot array.
+ * @first: The first slot to clear.
+ * @end: The slot after the last one to clear.
+ */
+static void clear_macro_slots(Macro **slots, unsigned int first, unsigned int end) {
+    for (; first < end; first++) {
+        slots[first] = NULL;
+    }
+}
+
+/**
+ * initialise_macro_table - Creates an empty macro table.
+ * @symbols: The interner of the source, which names the macros.
  *
- * This function checks if the given line is a macro definition and matches
- * any previously defined macro in the macro table.
- * Returns: The index of the macro if found, -1 otherwise.
+ * Returns: A pointer to the new table.
  */
-int is_saved_macro(const char *line, struct Macro_table *head) {
-    int k = 0;
-    struct Macro_table *curr = head;
-    char *orig ,*temp = safe_alloc(strlen(line)+1);
-    orig = strcpy(temp, line);
-    IGNORE_WHITESPACE(orig);
-    temp = orig;
-    while (isprint(*temp) && !isspace(*temp)) {
-        temp++;
+Macro_table *initialise_macro_table(const interner *symbols) {
+    Macro_table *table = safe_alloc(sizeof(Macro_table));
+    table->slots = safe_alloc(MACRO_TABLE_MIN_CAPACITY * sizeof(Macro *));
+    clear_macro_slots(table->slots, 0, MACRO_TABLE_MIN_CAPACITY);
+    table->capacity = MACRO_TABLE_MIN_CAPACITY;
+    table->count = 0;
+    table->symbols = symbols;
+    return table;
+}
+
+/**
+ * grow_macro_table - Doubles the number of slots until there is one for a symbol.
+ * @table: The table to grow.
+ * @symbol: The symbol that needs a slot.
+ */
+static void grow_macro_table(Macro_table *table, unsigned int symbol) {
+    unsigned int capacity = table->capacity;
+
+    while (capacity <= symbol) {
+        capacity *= 2;
     }
-    *temp = '\0';
-    while (curr != NULL && curr->macro_name != NULL) {
-        if (strcmp(curr->macro_name, orig) == 0) {
-            free_ptr(orig);
-            return k;
-        }
-        k++;
-        if (curr->next_macro == NULL) {
-            free_ptr(orig);
-            return -1;
-        }
-        curr = curr->next_macro;
+    table->slots = safe_realloc(table->slots, table->capacity * sizeof(Macro *),
+                                capacity * sizeof(Macro *));
+    clear_macro_slots(table->slots, table->capacity, capacity);
+    table->capacity = capacity;
+}
+
+/**
+ * find_macro - Looks a macro up by the interned id of its name.
+ * @table: The macro table.
+ * @symbol: The interned name, or NO_SYMBOL.
+ *
+ * Returns: The macro with that name, or NULL if there is none.
+ */
+Macro *find_macro(const Macro_table *table, unsigned int symbol) {
+    return symbol < table->capacity ? table->slots[symbol] : NULL;
+}
+
+/**
+ * add_macro - Adds a named macro to the table.
+ * @table: The macro table.
+ * @macro: The macro to add.
+ *
+ * A macro whose name is already in the table is not added.
+ * Returns: 1 if the macro was added, 0 if the name was already defined.
+ */
+int add_macro(Macro_table *table, Macro *macro) {
+    if (macro->symbol >= table->capacity) {
+        grow_macro_table(table, macro->symbol);
     }
-    free_ptr(orig);
-    return -1;
-}
\ No newline at end of file
+    if (table->slots[macro->symbol] != NULL) {
+        return 0;
+    }
+    table->slots[macro->symbol] = macro;
+    table->count++;
+    return 1;
+}
@@ -0,0 +1,163 @@
+#include "scan.h"
+#include "const_tables.h"
+
+/*
+ * Purpose:
+ * This file implements the whitespace skipping kernel declared in scan.h. It has a
+ * portable byte loop and, on x86 with a GNU-compatible compiler, SSE2 and AVX2
+ * versions built with the target attribute, so the rest of the assembler still
+ * compiles for the baseline CPU. The widest version the CPU supports is picked at
+ * run time; __builtin_cpu_supports is a single load and test.
+ *
+ * Most runs of whitespace are a separator or a short indentation, which the byte
+ * loop gets through faster than a vector version can be set up, so the vector
+ * versions only take over once a run is longer than SHORT_RUN. A vector version
+ * only handles whole blocks and leaves the tail of the text to the byte loop, so
+ * no load ever reaches past the end of the text.
+ *
+ * Line ends are found with memchr, which the C library already vectorises and
+ * dispatches by CPU; a kernel of our own measured no faster. Comment and blank
+ * lines need no kernel: a comment is told by its first character, and a blank
+ * line is one call to skip_spaces that reaches the end of the line.
+ *
+ * Key Functions:
+ * - `skip_spaces`: Skips the whitespace at the start of a text.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_SIMD
+#include <immintrin.h>
+#endif
+
+#define SSE2_WIDTH 16 /* Bytes compared at a time by the SSE2 kernels */
+#define AVX2_WIDTH 32 /* Bytes compared at a time by the AVX2 kernels */
+#define SHORT_RUN 8   /* Whitespace skipped a byte at a time before a kernel takes over */
+
+/* Besides ' ', the whitespace characters are the range '\t' to '\r' */
+#define FIRST_CONTROL_SPACE '\t'
+#define CONTROL_SPACE_RANGE ('\r' - '\t')
+
+/**
+ * Function: skip_spaces_scalar
+ * Purpose: Skips whitespace one character at a time.
+ *
+ * Parameters:
+ *   - text: The text.
+ *   - length: The number of characters in the text.
+ *
+ * Returns:
+ *   - The index of the first character that is not whitespace, or length.
+ */
+static size_t skip_spaces_scalar(const char *text, const size_t length) {
+  size_t i = 0;
+  while (i < length && CHAR_IS(text[i], CHAR_SPACE)) {
+    i++;
+  }
+  return i;
+}
+
+#ifdef SCAN_SIMD
+
+/**
+ * Function: skip_spaces_sse2
+ * Purpose: Skips whitespace 16 characters at a time.
+ *
+ * A byte is whitespace if it is ' ' or if subtracting '\t' leaves it no greater
+ * than CONTROL_SPACE_RANGE, which an unsigned minimum tests without a compare
+ * for greater-than.
+ *
+ * Parameters:
+ *   - text: The text.
+ *   - length: The number of characters in the text.
+ *
+ * Returns:
+ *   - The index of the first character that is not whitespace, or length.
+ */
+__attribute__((target("sse2")))
+static size_t skip_spaces_sse2(const char *text, const size_t length) {
+  const __m128i blank = _mm_set1_epi8(' ');
+  const __m128i first = _mm_set1_epi8(FIRST_CONTROL_SPACE);
+  const __m128i range = _mm_set1_epi8(CONTROL_SPACE_RANGE);
+  __m128i block, offset, spaces;
+  unsigned int mask;
+  size_t i;
+
+  for (i = 0; i + SSE2_WIDTH <= length; i += SSE2_WIDTH) {
+    block = _mm_loadu_si128((const __m128i *)(text + i));
+    offset = _mm_sub_epi8(block, first);
+    spaces = _mm_or_si128(_mm_cmpeq_epi8(block, blank),
+                          _mm_cmpeq_epi8(_mm_min_epu8(offset, range), offset));
+    mask = (unsigned int)_mm_movemask_epi8(spaces) ^ 0xffffU;
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz(mask);
+    }
+  }
+  return i + skip_spaces_scalar(text + i, length - i);
+}
+
+/**
+ * Function: skip_spaces_avx2
+ * Purpose: Skips whitespace 32 characters at a time, as skip_spaces_sse2 does.
+ *
+ * Parameters:
+ *   - text: The text.
+ *   - length: The number of characters in the text.
+ *
+ * Returns:
+ *   - The index of the first character that is not whitespace, or length.
+ */
+__attribute__((target("avx2")))
+static size_t skip_spaces_avx2(const char *text, const size_t length) {
+  const __m256i blank = _mm256_set1_epi8(' ');
+  const __m256i first = _mm256_set1_epi8(FIRST_CONTROL_SPACE);
+  const __m256i range = _mm256_set1_epi8(CONTROL_SPACE_RANGE);
+  __m256i block, offset, spaces;
+  unsigned int mask;
+  size_t i;
+
+  for (i = 0; i + AVX2_WIDTH <= length; i += AVX2_WIDTH) {
+    block = _mm256_loadu_si256((const __m256i *)(text + i));
+    offset = _mm256_sub_epi8(block, first);
+    spaces = _mm256_or_si256(_mm256_cmpeq_epi8(block, blank),
+                             _mm256_cmpeq_epi8(_mm256_min_epu8(offset, range), offset));
+    mask = ~(unsigned int)_mm256_movemask_epi8(spaces);
+    if (mask != 0) {
+      return i + (size_t)__builtin_ctz(mask);
+    }
+  }
+  return i + skip_spaces_scalar(text + i, length - i);
+}
+
+#endif /* SCAN_SIMD */
+
+/**
+ * Function: skip_spaces
+ * Purpose: Skips the whitespace at the start of a text, handing a run longer than
+ * SHORT_RUN to the widest kernel that fits the rest of the text and the CPU.
+ *
+ * Parameters:
+ *   - text: The text.
+ *   - length: The number of characters in the text.
+ *
+ * Returns:
+ *   - The index of the first character that is not whitespace, or length.
+ */
+size_t skip_spaces(const char *text, const size_t length) {
+  size_t i = 0;
+
+  while (i < SHORT_RUN && i < length && CHAR_IS(text[i], CHAR_SPACE)) {
+    i++;
+  }
+  if (i < SHORT_RUN) {
+    return i;
+  }
+#ifdef SCAN_SIMD
+  if (length - i >= AVX2_WIDTH && __builtin_cpu_supports("avx2")) {
+    return i + skip_spaces_avx2(text + i, length - i);
+  }
+  if (length - i >= SSE2_WIDTH && __builtin_cpu_supports("sse2")) {
+    return i + skip_spaces_sse2(text + i, length - i);
+  }
+#endif
+  return i + skip_spaces_scalar(text + i, length - i);
+}
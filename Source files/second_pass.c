@@ -3,160 +3,317 @@
 #include "parsing.h"
 #include "first_pass.h"
 #include "const_tables.h"
+#include "output.h"
 
 /*
- * create_ob_file - Generates the object file that contains both machine code and data.
- * @file_name: The name of the source file to generate the object file for.
- * @code: The machine code memory array.
- * @data: The data memory array.
- * @ICF: The final value of the instruction counter.
- * @DCF: The final value of the data counter.
+ * second_pass - Completes the assembly in memory.
+ * @ctx: The assembler context of the file, after the first pass.
  *
- * This function generates an object file (.ob) containing the machine code and data.
- * It writes the ICF (instruction counter) and DCF (data counter) in the header and
- * follows with the corresponding machine code and data.
- * The machine code starts at the address specified by the constant `START_ADDRESS`.
- * Each entry in the file consists of an address and a value in hexadecimal format.
+ * This function resolves the label references in the code image, then fills
+ * ctx->result with the entries and the final object words. Nothing is written
+ * to disk; the create_*_file functions format the result into the output files.
+ *
+ * Returns: NORMAL (errors found by the second pass are not fatal).
  */
-void create_ob_file(const char *file_name, const memory code,
-                    const memory data, int ICF, const int DCF) {
-  int i = 0, j = 0;
-  char *file_ob_name = add_extension(file_name, OBJECT_FILE_EXT);
-  FILE *file_ob = fopen(file_ob_name, "w");
-  free_ptr(file_ob_name);
-
-  if (file_ob == NULL) {
-    FILE_OPEN_ERROR();
-    free_all_memory();
-    exit(EXIT_FAILURE);
-  }
+enum errors second_pass(assembler_ctx *ctx) {
+  populate_labels(ctx);
+  collect_entries(ctx);
+  collect_object_words(ctx);
+  return NORMAL;
+}
 
-  fprintf(file_ob, "  %d %d\n", ICF - START_ADDRESS, DCF); /* header */
+/*
+ * populate_labels - Patches the label references that were left for the end of the source.
+ * @ctx: The assembler context holding the code image, the label and intern tables
+ * and the final instruction counter.
+ *
+ * The first pass backpatches every reference whose label's address it knows,
+ * so only references to data labels, which need the final instruction
+ * counter, to external labels, and to undefined labels, which are left as they
+ * are, are still chained from their labels. Each label with pending references
+ * is visited once and all of its words are patched in one loop. Every
+ * reference to an external label is recorded in ctx->result.externals, in
+ * code order.
+ */
+void populate_labels(assembler_ctx *ctx) {
+  unsigned int i;
+  int j, value;
+  const int ICF = ctx->IC;
+  const label_table_head label_table = *ctx->label_table;
+  const intern_table_head intern_table = *ctx->intern_table;
+  const intern_node *current;
+  const label_node *label;
+  const char *name;
+  memory_word *word;
+  assembler_symbol *externals;
+  assembler_result *result = &ctx->result;
 
-  /* Write machine code*/
-  for (i = 0; i + START_ADDRESS < ICF; i++) {
-    fprintf(file_ob, "%07d %06x\n", i + START_ADDRESS, (code)[i + START_ADDRESS].data.value);
+  /* An external reference is stored at the index of its record, which is in code order */
+  externals = safe_alloc((intern_table.count + 1) * sizeof(assembler_symbol));
+  for (j = 0; j < intern_table.count; j++) {
+    externals[j].name = NULL;
   }
 
-  /* Write data*/
-  for (j = 0; j < DCF; j++) {
-    fprintf(file_ob, "%07d %06x\n", j + ICF, (data)[j].data.value);
+  for (i = 0; i < label_table.capacity; i++) {
+    label = &label_table.slots[i];
+    if (label->symbol != i || label->fixups == NO_FIXUP || label->type == UNDEFINED) {
+      /* Handle error if label used but not declared */
+      continue;
+    }
+    if (label->linking_type == EXTERN) {
+      /* a relative reference to an extern label is an error, and is left as it is */
+      name = symbol_name(&ctx->symbols, label->symbol);
+      for (j = label->fixups; j != NO_FIXUP; j = current->next) {
+        current = &intern_table.items[j];
+        if (current->type == immediate) {
+          word = image_word(&ctx->code_image, current->mem_place);
+          word->operand.E = 1;
+          word->operand.value = 0;
+          externals[j].name = name;
+          externals[j].address = current->mem_place;
+        }
+      }
+      continue;
+    }
+    value = (label->type == DATA) ? label->value + ICF : label->value;
+    for (j = label->fixups; j != NO_FIXUP; j = current->next) {
+      current = &intern_table.items[j];
+      word = image_word(&ctx->code_image, current->mem_place);
+      if (current->type == immediate) {
+        word->operand.value = value;
+        word->operand.R = 1;
+      } else {
+        word->operand.A = 1;
+        word->operand.value = label->value - current->mem_place + 1;
+      }
+    }
   }
 
-  fclose(file_ob);
+  /* Close the gaps left by the references that are not external */
+  result->extern_count = 0;
+  for (j = 0; j < intern_table.count; j++) {
+    if (externals[j].name != NULL) {
+      externals[result->extern_count++] = externals[j];
+    }
+  }
+  result->externals = externals;
 }
 
 /*
- * create_entry_file - Generates the entry file containing all the entry labels.
- * @file_name: The name of the source file to generate the entry file for.
- * @label_table: The label table that contains all label information.
- * @entry_table: The entry table that contains all entry label names.
- * @ICF: The final instruction counter value.
+ * collect_entries - Lists the entry labels with their addresses.
+ * @ctx: The assembler context holding the label and entry tables and the final
+ * instruction counter.
  *
- * This function generates an entry file (.ent) listing the names and addresses
- * of the entry labels. Each entry consists of a label name and its address in the code
+ * This function fills ctx->result.entries with the names and addresses of the
+ * entry labels. Each entry consists of a label name and its address in the code
  * or data section. If any entry label is not found in the label table or is marked as
  * EXTERN, an error will be triggered.
- * If there are no entry labels, the entry file is removed.
  */
-void create_entry_file(const char *file_name,
-                       const label_table_head label_table,
-                       const entry_table_head entry_table, const int ICF) {
-  int remove_entry_file = 1;
-  entry_node *current;
+void collect_entries(assembler_ctx *ctx) {
+  int i;
+  const int ICF = ctx->IC;
+  const label_table_head label_table = *ctx->label_table;
+  const entry_table_head entry_table = *ctx->entry_table;
+  const entry_node *current;
   label_node *found_label;
-  char *file_ent_name = add_extension(file_name, ENTRIES_FILE_EXT);
-  FILE *file_entry = fopen(file_ent_name, "w");
+  assembler_result *result = &ctx->result;
 
-  if (file_entry == NULL) {
-    FILE_OPEN_ERROR();
-    free_all_memory();
-    exit(EXIT_FAILURE);
-  }
+  result->entries = safe_alloc((entry_table.count + 1) * sizeof(assembler_symbol));
+  result->entry_count = 0;
 
-  current = entry_table.root;
-
-  while (current != NULL) {
-    if ((found_label = find_label(current->name, label_table)) == NULL) {
+  for (i = 0; i < entry_table.count; i++) {
+    current = &entry_table.items[i];
+    if ((found_label = find_label(current->symbol, label_table)) == NULL) {
       /* Handle error if entry name is not defined in the code */
     } else {
       if (found_label->value == DEFAULT_EXTERN_VALUE) {
         /* Handle error if entry is marked as EXTERN */
       }
-      remove_entry_file = 0;
-      fprintf(file_entry, "%s %07d\n", current->name, (found_label->type == DATA) ? found_label->value + ICF : found_label->value);
+      result->entries[result->entry_count].name = symbol_name(&ctx->symbols, current->symbol);
+      result->entries[result->entry_count].address =
+          (found_label->type == DATA) ? found_label->value + ICF : found_label->value;
+      result->entry_count++;
     }
-    current = current->next_entry;
   }
-  fclose(file_entry);
+}
 
-  /* Remove entry file if no entries were written*/
-  if (remove_entry_file) {
-    remove(file_ent_name);
+/*
+ * collect_object_words - Lays out the final object words.
+ * @ctx: The assembler context holding the code and data images and the final
+ * instruction (ICF) and data (DCF) counters.
+ *
+ * This function copies the machine code followed by the data into
+ * ctx->result.words, so that word i is loaded at address START_ADDRESS + i.
+ * The address of every code word given the address of a label of the file,
+ * which is the word's R bit, is recorded in ctx->result.relocations, in code order.
+ */
+void collect_object_words(assembler_ctx *ctx) {
+  int i;
+  const memory_word *word;
+  const int code_size = ctx->IC - START_ADDRESS, data_size = ctx->DC;
+  assembler_result *result = &ctx->result;
+
+  result->words = safe_alloc((code_size + data_size + 1) * sizeof(unsigned long));
+  result->code_size = code_size;
+  result->data_size = data_size;
+  result->relocations = safe_alloc((code_size + 1) * sizeof(int));
+  result->relocation_count = 0;
+
+  for (i = 0; i < code_size; i++) {
+    word = image_word(&ctx->code_image, i + START_ADDRESS);
+    result->words[i] = word->data.value;
+    if (word->operand.R) {
+      result->relocations[result->relocation_count++] = i + START_ADDRESS;
+    }
+  }
+  for (i = 0; i < data_size; i++) {
+    result->words[code_size + i] = image_word(&ctx->data_image, i)->data.value;
   }
 }
 
 /*
- * populate_labels - Populates labels in code, modifying the code memory values accordingly.
- * @file_name: The name of the source file.
- * @code: The machine code memory array.
- * @label_table: The label table that contains all label information.
- * @intern_table: The intern table that contains all internal labels.
- * @ICF: The instruction counter final value.
+ * create_ob_file - Generates the object file that contains both machine code and data.
+ * @ctx: The assembler context holding the object words of the result.
  *
- * This function updates the machine code array by replacing label references with
- * their corresponding values. It also generates an extern file (.ext) for labels with external references.
- * The labels are checked for validity, and any errors encountered (e.g., undefined labels or invalid label types) are flagged.
- * The extern file is removed if no extern labels are present.
+ * This function generates an object file (.ob) containing the machine code and data.
+ * It writes the ICF (instruction counter) and DCF (data counter) in the header and
+ * follows with the corresponding machine code and data.
+ * The machine code starts at the address specified by the constant `START_ADDRESS`.
+ * Each entry in the file consists of an address and a value in hexadecimal format.
+ * The file is formatted into one buffer, sized exactly, and written in one call.
+ *
+ * Returns: NORMAL on success, ERROR if the file could not be created.
  */
-void populate_labels(const char *file_name, memory code,
-                     const label_table_head label_table,
-                     const intern_table_head intern_table, const int ICF) {
-  int remove_extern_file = 1;
-  intern_node *current = intern_table.root;
-  label_node *found_label;
-  char *file_ext_name = add_extension(file_name, EXTERNALS_FILE_EXT);
-  FILE *file_extern = fopen(file_ext_name, "w");
+enum errors create_ob_file(assembler_ctx *ctx) {
+  int i;
+  const assembler_result *result = &ctx->result;
+  const int word_count = result->code_size + result->data_size;
+  const size_t address_length = decimal_length((unsigned long)(START_ADDRESS + word_count),
+                                                OB_ADDRESS_WIDTH);
+  char *file_ob_name = add_extension(ctx->file_name, OBJECT_FILE_EXT);
+  char *text, *out;
+  int written;
 
-  if (file_extern == NULL) {
+  /* "  ICF DCF\n", then "address word\n" per word */
+  text = out = safe_alloc(2 * MAX_DECIMAL_DIGITS + 4 + word_count * (address_length + HEX_WORD_DIGITS + 2));
+  *out++ = ' ';
+  *out++ = ' ';
+  out += put_decimal(out, (unsigned long)result->code_size, 0, ' ');
+  *out++ = ' ';
+  out += put_decimal(out, (unsigned long)result->data_size, 0, ' ');
+  *out++ = '\n';
+
+  /* Write machine code followed by data*/
+  for (i = 0; i < word_count; i++) {
+    out += put_decimal(out, (unsigned long)(i + START_ADDRESS), OB_ADDRESS_WIDTH, '0');
+    *out++ = ' ';
+    out += put_hex_word(out, result->words[i]);
+    *out++ = '\n';
+  }
+
+  written = write_output_file(file_ob_name, text, (size_t)(out - text));
+  free_ptr(text);
+  free_ptr(file_ob_name);
+  if (!written) {
     FILE_OPEN_ERROR();
-    free_all_memory();
-    exit(EXIT_FAILURE);
+    return ERROR;
   }
+  return NORMAL;
+}
 
-  while (current != NULL) {
-    if ((found_label = find_label(current->name, label_table)) == NULL) {
-      /* Handle error if label used but not declared */
-    } else {
-      if (current->type == immediate) {
-        int value = found_label->value;
-        value = (found_label->type == DATA) ? value + ICF : value;
-        (code)[current->mem_place].operand.value = value;
-
-        if (found_label->linking_type == EXTERN) {
-          (code)[current->mem_place].operand.E = 1;
-          (code)[current->mem_place].operand.value = 0;
-          remove_extern_file = 0;
-          fprintf(file_extern, "%s %7d\n", current->name, current->mem_place);
-        } else {
-          (code)[current->mem_place].operand.R = 1;
-        }
-      } else if (current->type == relative) {
-        if (found_label->linking_type == EXTERN) {
-          /* Handle error: cannot use extern label as relative parameter */
-        } else {
-          (code)[current->mem_place].operand.A = 1;
-          (code)[current->mem_place].operand.value = found_label->value - current->mem_place + 1;
-        }
-      }
+/*
+ * create_entry_file - Generates the entry file containing all the entry labels.
+ * @ctx: The assembler context holding the entries of the result.
+ *
+ * This function generates an entry file (.ent) listing the names and addresses
+ * of the entry labels, formatted into one buffer and written in one call.
+ * If there are no entry labels, no entry file is created, and one left by an
+ * earlier run is removed only if the context asks for it.
+ *
+ * Returns: NORMAL on success, ERROR if the file could not be created.
+ */
+enum errors create_entry_file(assembler_ctx *ctx) {
+  int i;
+  const assembler_result *result = &ctx->result;
+  char *file_ent_name = add_extension(ctx->file_name, ENTRIES_FILE_EXT);
+  size_t size = 0, length;
+  char *text, *out;
+  int written;
+
+  /* Create no file without entries; on request, remove the one left by an earlier run */
+  if (result->entry_count == 0) {
+    if (ctx->remove_stale) {
+      remove(file_ent_name);
     }
-    current = current->next_intern;
+    return NORMAL;
+  }
+  for (i = 0; i < result->entry_count; i++) {
+    size += strlen(result->entries[i].name) + MAX_DECIMAL_DIGITS + 2;
+  }
+  text = out = safe_alloc(size);
+  for (i = 0; i < result->entry_count; i++) {
+    length = strlen(result->entries[i].name);
+    memcpy(out, result->entries[i].name, length);
+    out += length;
+    *out++ = ' ';
+    out += put_decimal(out, (unsigned long)result->entries[i].address, ENT_ADDRESS_WIDTH, '0');
+    *out++ = '\n';
   }
+  written = write_output_file(file_ent_name, text, (size_t)(out - text));
+  free_ptr(text);
+
+  if (!written) {
+    FILE_OPEN_ERROR();
+    return ERROR;
+  }
+  return NORMAL;
+}
+
+/*
+ * create_extern_file - Generates the extern file listing the external references.
+ * @ctx: The assembler context holding the externals of the result.
+ *
+ * This function generates an extern file (.ext) with the name of each external
+ * label and the address of the word referring to it, formatted into one buffer
+ * and written in one call.
+ * If no extern labels are referenced, no extern file is created, and one left
+ * by an earlier run is removed only if the context asks for it.
+ *
+ * Returns: NORMAL on success, ERROR if the file could not be created.
+ */
+enum errors create_extern_file(assembler_ctx *ctx) {
+  int i;
+  const assembler_result *result = &ctx->result;
+  char *file_ext_name = add_extension(ctx->file_name, EXTERNALS_FILE_EXT);
+  size_t size = 0, length;
+  char *text, *out;
+  int written;
 
-  fclose(file_extern);
+  /* Create no file without externals; on request, remove the one left by an earlier run */
+  if (result->extern_count == 0) {
+    if (ctx->remove_stale) {
+      remove(file_ext_name);
+    }
+    return NORMAL;
+  }
+  for (i = 0; i < result->extern_count; i++) {
+    size += strlen(result->externals[i].name) + MAX_DECIMAL_DIGITS + 2;
+  }
+  text = out = safe_alloc(size);
+  for (i = 0; i < result->extern_count; i++) {
+    length = strlen(result->externals[i].name);
+    memcpy(out, result->externals[i].name, length);
+    out += length;
+    *out++ = ' ';
+    out += put_decimal(out, (unsigned long)result->externals[i].address, EXT_ADDRESS_WIDTH, ' ');
+    *out++ = '\n';
+  }
+  written = write_output_file(file_ext_name, text, (size_t)(out - text));
+  free_ptr(text);
 
-  /*Remove extern file if no extern labels were written*/
-  if (remove_extern_file) {
-    remove(file_ext_name);
+  if (!written) {
+    FILE_OPEN_ERROR();
+    return ERROR;
   }
-}
\ No newline at end of file
+  return NORMAL;
+}
@@ -0,0 +1,436 @@
+#define _POSIX_C_SOURCE 200112L /* for mmap and fstat */
+#include "token_file.h"
+#include "preprocessor.h"
+#include "memory_utility.h"
+#include "file_extensions.h"
+#include "output.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Purpose:
+ * This file implements the .amt file, the lexed form of the preprocessor's output.
+ * Writing lays the sections out in one buffer and renames the file into place; loading
+ * maps the whole file and points the context's token stream and expanded source into
+ * the mapping, so a source that has not changed since it was last assembled is neither
+ * preprocessed nor lexed again.
+ *
+ * Damage is caught by a checksum over the whole file, checked together with the
+ * header and the section bounds before the context refers to anything in it; the
+ * records themselves are not walked again. A file that fails a check is treated like
+ * a stale one, and the source is preprocessed again.
+ *
+ * Key Functions:
+ * - `digest_source`: Computes the digest the file is keyed on.
+ * - `checksum_file`: Computes the checksum that detects a damaged file.
+ * - `write_token_file`: Writes the preprocessed source of a context to the .amt file.
+ * - `load_token_file`: Maps the .amt file of a context in place of preprocessing.
+ * - `close_token_file`: Unmaps it.
+ */
+
+#define BYTE_ORDER_MARK 0x01020304U /* Reads back differently on a machine of another byte order */
+#define DIGEST_MASK 0xffffffffUL    /* Each digest word holds 32 bits, whatever the size of a long */
+#define SIZE_LIMIT ((size_t)-1)     /* The largest size_t */
+
+/*
+ * Struct: section_offsets
+ * Where each section of a .amt file starts, and where the file ends.
+ */
+typedef struct {
+  size_t symbols;
+  size_t macros;
+  size_t tokens;
+  size_t lines;
+  size_t strings;
+  size_t text;
+  size_t end;
+} section_offsets;
+
+/**
+ * Function: align_section
+ * Purpose: Rounds a section size up to the section alignment.
+ *
+ * Parameters:
+ *   - size: The number of bytes in the section.
+ *
+ * Returns:
+ *   - The number of bytes the section takes in the file.
+ */
+static size_t align_section(const size_t size) {
+  return (size + TOKEN_FILE_ALIGNMENT - 1) / TOKEN_FILE_ALIGNMENT * TOKEN_FILE_ALIGNMENT;
+}
+
+/**
+ * Function: add_section
+ * Purpose: Places a section after the previous one, unless the file size would overflow.
+ *
+ * Parameters:
+ *   - offset: The offset of the section; advanced past it on success.
+ *   - count: The number of elements in the section.
+ *   - element_size: The size of an element.
+ *
+ * Returns:
+ *   - 1 on success, 0 if the section does not fit in a size_t.
+ */
+static int add_section(size_t *offset, const unsigned long count, const size_t element_size) {
+  size_t size;
+
+  if (count > (SIZE_LIMIT - TOKEN_FILE_ALIGNMENT) / element_size) {
+    return 0;
+  }
+  size = align_section((size_t)count * element_size);
+  if (size > SIZE_LIMIT - *offset) {
+    return 0;
+  }
+  *offset += size;
+  return 1;
+}
+
+/**
+ * Function: locate_sections
+ * Purpose: Computes where the sections of a .amt file start from the counts in its header.
+ *
+ * Parameters:
+ *   - header: The header of the file.
+ *   - at: Output: the offset of each section.
+ *
+ * Returns:
+ *   - 1 on success, 0 if a count is negative or the sizes overflow.
+ */
+static int locate_sections(const token_file_header *header, section_offsets *at) {
+  size_t offset = align_section(sizeof(token_file_header));
+
+  if (header->token_count < 0 || header->line_count < 0 ||
+      header->text_length >= (unsigned long)SIZE_LIMIT) {
+    return 0;
+  }
+  at->symbols = offset;
+  if (!add_section(&offset, header->symbol_count, sizeof(token_file_string))) {
+    return 0;
+  }
+  at->macros = offset;
+  if (!add_section(&offset, header->macro_count, sizeof(unsigned int))) {
+    return 0;
+  }
+  at->tokens = offset;
+  if (!add_section(&offset, (unsigned long)header->token_count, sizeof(token))) {
+    return 0;
+  }
+  at->lines = offset;
+  if (!add_section(&offset, (unsigned long)header->line_count, sizeof(token_line))) {
+    return 0;
+  }
+  at->strings = offset;
+  if (!add_section(&offset, header->strings_length, 1)) {
+    return 0;
+  }
+  at->text = offset;
+  if (!add_section(&offset, header->text_length + 1, 1)) {
+    return 0;
+  }
+  at->end = offset;
+  return 1;
+}
+
+/**
+ * Function: put_symbols
+ * Purpose: Puts the records of the interned symbols and their strings into a .amt file.
+ *
+ * Parameters:
+ *   - records: The symbols section.
+ *   - strings: The strings section.
+ *   - symbols: The interner.
+ */
+static void put_symbols(token_file_string *records, char *strings, const interner *symbols) {
+  const symbol *entry;
+  unsigned long offset = 0;
+  unsigned int id;
+
+  for (id = 0; id < symbols->count; id++) {
+    entry = &symbols->symbols[id];
+    records[id].offset = offset;
+    records[id].length = entry->length;
+    records[id].hash = entry->hash;
+    memcpy(strings + offset, entry->name, entry->length + 1);
+    offset += entry->length + 1;
+  }
+}
+
+/**
+ * Function: put_macros
+ * Purpose: Puts the interned names of the macros into a .amt file.
+ *
+ * Parameters:
+ *   - out: The macros section.
+ *   - macros: The macro table.
+ */
+static void put_macros(unsigned int *out, const Macro_table *macros) {
+  unsigned int i;
+
+  for (i = 0; i < macros->capacity; i++) {
+    if (macros->slots[i] != NULL) {
+      *out++ = macros->slots[i]->symbol;
+    }
+  }
+}
+
+/**
+ * Function: checksum_file
+ * Purpose: Computes the checksum of a .amt file, whose checksum field must be zero.
+ *
+ * The two hashes of digest_source are taken over 32-bit words rather than bytes, each
+ * in two lanes, one over the even words and one over the odd words, so that the four
+ * multiplications of a step do not wait on each other. Every step is one-to-one in
+ * the word and in the state of its lane, and the lanes are combined with xor, so any
+ * change confined to one word always changes both hashes.
+ *
+ * Parameters:
+ *   - data: The file, a multiple of TOKEN_FILE_ALIGNMENT bytes long.
+ *   - size: The size of the file.
+ *   - checksum: Output: the checksum.
+ */
+static void checksum_file(const char *data, const size_t size,
+                          unsigned long checksum[SOURCE_DIGEST_WORDS]) {
+  const unsigned int *words = (const unsigned int *)data;
+  const size_t count = size / sizeof(unsigned int);
+  unsigned long fnv_even = 2166136261UL, fnv_odd = 2166136261UL;
+  unsigned long mix_even = 0x6a09e667UL, mix_odd = 0x6a09e667UL;
+  size_t i;
+
+  for (i = 0; i + 1 < count; i += 2) {
+    fnv_even = ((fnv_even ^ words[i]) * 16777619UL) & DIGEST_MASK;
+    fnv_odd = ((fnv_odd ^ words[i + 1]) * 16777619UL) & DIGEST_MASK;
+    mix_even = (((mix_even << 5) | (mix_even >> 27)) & DIGEST_MASK) ^ words[i];
+    mix_even = (mix_even * 0x9e3779b1UL) & DIGEST_MASK;
+    mix_odd = (((mix_odd << 5) | (mix_odd >> 27)) & DIGEST_MASK) ^ words[i + 1];
+    mix_odd = (mix_odd * 0x9e3779b1UL) & DIGEST_MASK;
+  }
+  checksum[0] = fnv_even ^ fnv_odd;
+  checksum[1] = mix_even ^ mix_odd;
+}
+
+/**
+ * Function: digest_source
+ * Purpose: Computes the 64-bit digest of a source as two 32-bit hashes.
+ *
+ * The first word is the FNV-1a hash of hash_text. The second rotates and
+ * multiplies by an odd constant, so an edit that collides in one word is very
+ * unlikely to collide in the other. Both are computed in one pass.
+ *
+ * Parameters:
+ *   - text: The source.
+ *   - length: The number of characters in the source.
+ *   - digest: Output: the digest.
+ */
+void digest_source(const char *text, size_t length, unsigned long digest[SOURCE_DIGEST_WORDS]) {
+  unsigned long fnv = 2166136261UL, mix = 0x6a09e667UL;
+  unsigned char c;
+
+  while (length-- > 0) {
+    c = (unsigned char)*text++;
+    fnv = ((fnv ^ c) * 16777619UL) & DIGEST_MASK;
+    mix = (((mix << 5) | (mix >> 27)) & DIGEST_MASK) ^ c;
+    mix = (mix * 0x9e3779b1UL) & DIGEST_MASK;
+  }
+  digest[0] = fnv;
+  digest[1] = mix;
+}
+
+/**
+ * Function: write_token_file
+ * Purpose: Writes the preprocessed source of a context to the .amt file.
+ *
+ * The whole file is laid out in one buffer and written with write_output_file, so a run
+ * that has the old file mapped keeps reading the old contents, and a reader never maps
+ * a file that is still being written.
+ *
+ * Parameters:
+ *   - ctx: The context, after preprocessing.
+ *   - source_size: The size of the .as file.
+ *   - source_digest: The digest of the .as file.
+ *
+ * Returns:
+ *   - 1 on success, 0 if the file could not be written.
+ */
+int write_token_file(const assembler_ctx *ctx, const unsigned long source_size,
+                     const unsigned long source_digest[SOURCE_DIGEST_WORDS]) {
+  char *output_file = add_extension(ctx->file_name, TOKEN_FILE_EXT);
+  token_file_header header;
+  section_offsets at;
+  unsigned int id;
+  char *file;
+  int written;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TOKEN_FILE_MAGIC, sizeof(header.magic));
+  header.version = TOKEN_FILE_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.token_size = sizeof(token);
+  header.line_size = sizeof(token_line);
+  header.symbol_count = ctx->symbols.count;
+  header.macro_count = (unsigned int)ctx->macros->count;
+  header.token_count = ctx->tokens.token_count;
+  header.line_count = ctx->tokens.line_count;
+  header.source_size = source_size;
+  memcpy(header.source_digest, source_digest, sizeof(header.source_digest));
+  header.text_length = ctx->expanded.length;
+  for (id = 0; id < ctx->symbols.count; id++) {
+    header.strings_length += ctx->symbols.symbols[id].length + 1;
+  }
+  if (!locate_sections(&header, &at)) {
+    free_ptr(output_file);
+    return 0;
+  }
+
+  file = safe_alloc(at.end);
+  memset(file, 0, at.end); /* the padding and the checksum */
+  memcpy(file, &header, sizeof(header));
+  put_symbols((token_file_string *)(file + at.symbols), file + at.strings, &ctx->symbols);
+  put_macros((unsigned int *)(file + at.macros), ctx->macros);
+  memcpy(file + at.tokens, ctx->tokens.tokens, ctx->tokens.token_count * sizeof(token));
+  memcpy(file + at.lines, ctx->tokens.lines, ctx->tokens.line_count * sizeof(token_line));
+  memcpy(file + at.text, ctx->expanded.text, ctx->expanded.length + 1);
+  checksum_file(file, at.end, ((token_file_header *)file)->checksum);
+
+  written = write_output_file(output_file, file, at.end);
+  free_ptr(file);
+  free_ptr(output_file);
+  return written;
+}
+
+/**
+ * Function: is_usable_file
+ * Purpose: Checks that a mapped .amt file was written by this build for the current source
+ * and has not been damaged since.
+ *
+ * The checksum field is cleared in the private mapping to recompute the checksum; nothing
+ * reads it afterwards.
+ *
+ * Parameters:
+ *   - data: The mapped file.
+ *   - size: The size of the file.
+ *   - source_size: The size of the .as file.
+ *   - source_digest: The digest of the .as file.
+ *   - at: Output: the offset of each section.
+ *
+ * Returns:
+ *   - 1 if the sections fill the file exactly and the checksum matches, 0 otherwise.
+ */
+static int is_usable_file(char *data, const size_t size, const unsigned long source_size,
+                          const unsigned long source_digest[SOURCE_DIGEST_WORDS],
+                          section_offsets *at) {
+  token_file_header *header = (token_file_header *)data;
+  unsigned long stored[SOURCE_DIGEST_WORDS], computed[SOURCE_DIGEST_WORDS];
+
+  if (size < sizeof(token_file_header) ||
+      memcmp(header->magic, TOKEN_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != TOKEN_FILE_VERSION || header->byte_order != BYTE_ORDER_MARK ||
+      header->token_size != sizeof(token) || header->line_size != sizeof(token_line) ||
+      header->source_size != source_size ||
+      memcmp(header->source_digest, source_digest, sizeof(header->source_digest)) != 0 ||
+      !locate_sections(header, at) || at->end != size) {
+    return 0;
+  }
+  memcpy(stored, header->checksum, sizeof(stored));
+  memset(header->checksum, 0, sizeof(header->checksum));
+  checksum_file(data, size, computed);
+  return memcmp(stored, computed, sizeof(stored)) == 0;
+}
+
+/**
+ * Function: load_token_file
+ * Purpose: Maps the .amt file of a context and sets the context up from it.
+ *
+ * The tokens, lines, strings and expanded source are used in place. Only the interner's
+ * index and the macro table are rebuilt, from the stored strings and hashes. Once the
+ * header, the section bounds and the checksum have been checked, the records are
+ * trusted as written.
+ *
+ * Parameters:
+ *   - ctx: The context, before preprocessing.
+ *   - source_size: The size of the .as file.
+ *   - source_digest: The digest of the .as file.
+ *
+ * Returns:
+ *   - 1 if the file was loaded, 0 if it is missing, stale, damaged or unusable.
+ */
+int load_token_file(assembler_ctx *ctx, const unsigned long source_size,
+                    const unsigned long source_digest[SOURCE_DIGEST_WORDS]) {
+  char *input_file = add_extension(ctx->file_name, TOKEN_FILE_EXT);
+  const token_file_header *header;
+  const token_file_string *strings;
+  const unsigned int *macro_symbols;
+  const char *name;
+  section_offsets at;
+  struct stat info;
+  Macro_table *macros;
+  Macro *macro;
+  char *data;
+  size_t size;
+  unsigned int i;
+  int fd = open(input_file, O_RDONLY);
+
+  free_ptr(input_file);
+  if (fd < 0) {
+    return 0;
+  }
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+  size = (size_t) info.st_size;
+  data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return 0;
+  }
+  if (!is_usable_file(data, size, source_size, source_digest, &at)) {
+    munmap(data, size);
+    return 0;
+  }
+  header = (const token_file_header *)data;
+
+  strings = (const token_file_string *)(data + at.symbols);
+  init_interner(&ctx->symbols, header->symbol_count);
+  for (i = 0; i < header->symbol_count; i++) {
+    name = data + at.strings + strings[i].offset;
+    restore_symbol(&ctx->symbols, name, strings[i].length, strings[i].hash);
+  }
+  macro_symbols = (const unsigned int *)(data + at.macros);
+  macros = initialise_macro_table(&ctx->symbols);
+  for (i = 0; i < header->macro_count; i++) {
+    macro = safe_alloc(sizeof(Macro));
+    memset(macro, 0, sizeof(Macro)); /* only the names are needed after preprocessing */
+    macro->symbol = macro_symbols[i];
+    macro->macro_name = symbol_name(&ctx->symbols, macro->symbol);
+    add_macro(macros, macro);
+  }
+
+  ctx->macros = macros;
+  ctx->tokens.tokens = (token *)(data + at.tokens);
+  ctx->tokens.token_count = ctx->tokens.token_capacity = header->token_count;
+  ctx->tokens.lines = (token_line *)(data + at.lines);
+  ctx->tokens.line_count = ctx->tokens.line_capacity = header->line_count;
+  ctx->expanded.text = data + at.text;
+  ctx->expanded.length = ctx->expanded.capacity = header->text_length;
+  ctx->token_file = data;
+  ctx->token_file_size = size;
+  return 1;
+}
+
+/**
+ * Function: close_token_file
+ * Purpose: Unmaps the .amt file loaded into a context, if any.
+ *
+ * Parameters:
+ *   - ctx: The context.
+ */
+void close_token_file(assembler_ctx *ctx) {
+  if (ctx->token_file != NULL) {
+    munmap(ctx->token_file, ctx->token_file_size);
+    ctx->token_file = NULL;
+  }
+}
@@ -9,64 +9,57 @@
 #include "second_pass.h"
 #include "tables.h"
 #include "memory_utility.h"
-#include <ctype.h>
 
 /**
  * Title: Instruction Validation
  *
  * Purpose:
- * This function checks if a given line starts with a valid instruction like "data", "string", etc.
- * It skips any leading whitespace and matches the beginning of the line to one of the predefined
- * instruction names. If a valid instruction is found, it sets the instruction type.
+ * This function checks if the next token of a line is an instruction like ".data", ".string", etc.
+ * An instruction is the '.' character with the name of the instruction glued to it. If a valid
+ * instruction is found, both tokens are consumed and the instruction type is set.
  * If no valid instruction is found, an error is generated.
  *
- * @param line Pointer to the line being checked for a valid instruction.
+ * @param line The tokens of the line being checked for a valid instruction.
  * @param instruction_type Pointer to the instruction type to set if an instruction is found.
  * @param line_number The current line number for error reporting.
  *
  * @return int Returns 1 if a valid instruction is found, 0 if no valid instruction is found.
  */
-int is_instruction(char **line, inst *instruction_type, int line_number) {
-  char *work_line = *line;
+int is_instruction(token_cursor *line, inst *instruction_type, int line_number) {
+  const token *dot = peek_token(line), *name;
   int i;
-  while (isspace(*work_line)) {
-    work_line++;
+  if (dot == NULL || dot->kind != TOKEN_DOT) {
+    return 0;
   }
-  if (*work_line == INSTRUCTION_START_CHAR) {
-    work_line++;
+  line->position++;
+  name = peek_token(line);
+  if (name != NULL && name->kind == TOKEN_IDENTIFIER && name->offset == dot->offset + 1) {
     for (i=0; i < NUMBER_OF_INSTRUCTION_TYPES; i++) {
-      if (strncmp(work_line, instructions[i].name, strlen(instructions[i].name)) == 0) {
-        *line = work_line + strlen(instructions[i].name);
+      if (token_equals(line, name, instructions[i].name)) {
+        line->position++;
         *instruction_type = instructions[i].instruction;
         return 1;
       }
     }
-    INVALID_INSTRUCTION(line_number);  /* Call error handler for invalid instruction.*/
-    *instruction_type = INVALID_INST;
-    return 1;
   }
-  return 0;
+  INVALID_INSTRUCTION(line_number);  /* Call error handler for invalid instruction.*/
+  *instruction_type = INVALID_INST;
+  return 1;
 }
 
 /**
  * Title: Whitespace Check
  *
  * Purpose:
- * This function checks if a line consists only of whitespace characters or is empty.
- * It is useful for skipping over empty lines during parsing.
+ * This function checks if the rest of a line consists only of whitespace characters or is empty,
+ * that is if no token is left on it. It is useful for skipping over empty lines during parsing.
  *
- * @param line The line to check for whitespace.
+ * @param line The tokens of the line to check for whitespace.
  *
- * @return int Returns 1 if the line consists only of whitespace, 0 if it contains other characters.
+ * @return int Returns 1 if the rest of the line consists only of whitespace, 0 if it contains other characters.
  */
-int is_whitespace(const char *line) {
-  if (strlen(line) == 0) {
-    return 1;
-  }
-  while (*line != '\0' && isspace(*line)) {
-    line++;
-  }
-  return *line == '\0';
+int is_whitespace(const token_cursor *line) {
+  return peek_token(line) == NULL;
 }
 
 /**
@@ -74,17 +67,14 @@ int is_whitespace(const char *line) {
  *
  * Purpose:
  * This function checks if the given line is a comment. A line is considered a comment
- * if it starts with the semicolon character (';').
+ * if it starts with the semicolon character (';'), which the lexer turns into a single token.
  *
- * @param line The line to check for being a comment.
+ * @param line The tokens of the line to check for being a comment.
  *
  * @return int Returns 1 if the line is a comment, 0 if it is not.
  */
-int is_comment(const char *line) {
-  if (*line == ';') {
-    return 1;
-  }
-  return 0;
+int is_comment(const token_cursor *line) {
+  return line->count > 0 && line->tokens[0].kind == TOKEN_COMMENT;
 }
 
 /*
@@ -142,26 +132,26 @@ int is_empty(op_type type) {
  * Purpose: Checks if the given operand is a valid register.
  *
  * Parameters:
- *   operand - The operand string to check.
+ *   line - The tokens of the line holding the operand.
+ *   first - The index of the first token of the operand.
+ *   end - The index of the first token after the operand.
  *
  * Returns:
  *   - True if the operand represents a valid register (r0 to r7).
  *   - False otherwise.
  */
-int is_register(char *operand) {
-    if (*operand == REGISTER_INDICATOR) {
-        const int register_number = *(operand + 1) - '0';
-        if (register_number < 0 || register_number > REGISTER_COUNT) {
-            /* not a register, might be a label starting with r like "r8" or "right" */
-            return 0;
-        }
-        if (is_whitespace(operand + 2)) {
-            return 1;
-        }
-        /* might be a label like "r3d" which is valid */
+int is_register(const token_cursor *line, const int first, const int end) {
+    const token *operand = &line->tokens[first];
+    const char *text = line->text + operand->offset;
+    int register_number;
+    if (first + 1 != end || operand->kind != TOKEN_IDENTIFIER || operand->length != 2 ||
+        *text != REGISTER_INDICATOR) {
+        /* might be a label like "r3d" or "right" which is valid */
         return 0;
     }
-    return 0;
+    register_number = *(text + 1) - '0';
+    /* not a register, might be a label starting with r like "r9" */
+    return register_number >= 0 && register_number <= REGISTER_COUNT;
 }
 
 
@@ -169,44 +159,100 @@ int is_register(char *operand) {
  * Title: Label Check
  *
  * Purpose:
- * This function checks if a given line starts with a valid label. A valid label starts with
- * a letter and consists of alphanumeric characters or the label definition character ('_').
- * If a valid label is found, it sets the label name and returns a success status.
+ * This function checks if a given line starts with a valid label. A valid label is an identifier
+ * of at most MAX_LABEL_LENGTH characters with the label definition character (':') glued to it.
+ * If a valid label is found, both tokens are consumed and the label is set to the interned id
+ * of the identifier, so no copy of the name is made.
  *
- * @param line Pointer to the line being checked for a label.
- * @param label_name Pointer to a string where the label name will be stored if found.
- * @param line_number The current line number for error reporting.
+ * @param line The tokens of the line being checked for a label.
+ * @param label Pointer to where the interned name of the label will be stored if found.
  *
  * @return int Returns 1 if a valid label is found, 0 if no label is found.
  */
-int is_label(char **line, char **label_name, int line_number) {
-    int label_length = 0;
-    char *work_name = safe_alloc(MAX_LABEL_LENGTH + 1), *work_line = *line;
-    char *name = work_name;
-    while (isspace(*work_line)) {
-        work_line++;
+int is_label(token_cursor *line, unsigned int *label) {
+    const token *name = peek_token(line), *colon;
+    if (name == NULL || name->kind != TOKEN_IDENTIFIER || name->length > MAX_LABEL_LENGTH ||
+        line->position + 1 >= line->count) {
+        return 0;
     }
-    if (isalpha(*work_line)) {
-        *work_name = *work_line;
-        work_line++;
-        work_name++;
-        label_length++;
-    } /*checks that first character is a letter*/
-    for (; valid_label_char(work_line, label_length); work_line++) {
-        if (*work_line == LABEL_DEF_CHAR) {
-            *work_name = '\0';
-            *label_name = name;
-            *line = ++work_line;
-            if (label_length > MAX_LABEL_LENGTH) {
-                LABEL_TOO_LONG(line_number);  /* Error handler for too long label.*/
-                return 0;
-            }
-            return 1;
-        }
-        *work_name = *work_line;
-        work_name++;
-        label_length++;
+    colon = name + 1;
+    if (colon->kind != TOKEN_COLON || colon->offset != name->offset + name->length) {
+        return 0;
     }
-    free_ptr(name);
-    return 0;
-}
\ No newline at end of file
+    *label = name->symbol;
+    line->position += 2;
+    return 1;
+}
+
+/* The digits a data word can have at most: DATA_MIN has 7, and 8 leaves room to detect overflow */
+#define MAX_DATA_DIGITS 8
+
+/**
+ * Title: Four-Digit Conversion
+ *
+ * Purpose:
+ * This function converts four decimal digits at once. The characters are packed into one word,
+ * first character lowest, so each step combines neighbouring fields with a single multiplication:
+ * the pairs of digits (x 10 + 1 = 2561 per byte), then the pair of two-digit numbers
+ * (x 100 + 1 = 6553601 per half). Only the low 32 bits of each product matter, so the result
+ * is the same whatever the width of unsigned long.
+ *
+ * @param digits Four decimal digit characters.
+ *
+ * @return unsigned long Returns the value of the four digits.
+ */
+static unsigned long convert_four_digits(const char *digits) {
+    unsigned long word = (unsigned long)(unsigned char)digits[0] |
+                         (unsigned long)(unsigned char)digits[1] << 8 |
+                         (unsigned long)(unsigned char)digits[2] << 16 |
+                         (unsigned long)(unsigned char)digits[3] << 24;
+
+    word = ((word & 0x0F0F0F0FUL) * 2561UL) >> 8;
+    word = ((word & 0x00FF00FFUL) * 6553601UL) >> 16;
+    return word & 0xFFFFUL;
+}
+
+/**
+ * Title: Data Number Parsing
+ *
+ * Purpose:
+ * This function parses a number token of a .data list. The lexer guarantees that the token is
+ * an optional sign followed by digits, so no character is checked again. Leading zeros are
+ * skipped; a number with more significant digits than MAX_DATA_DIGITS is out of range without
+ * being converted, and the others are converted four digits at a time, so no intermediate
+ * value can overflow.
+ *
+ * @param text The characters of the token.
+ * @param length The number of characters in the token.
+ * @param value Pointer to where the value is stored; left unchanged if it is out of range.
+ *
+ * @return int Returns 1 if the value fits in a data word, 0 if it is out of range.
+ */
+int parse_data_number(const char *text, size_t length, long *value) {
+    unsigned long magnitude = 0;
+    int negative = 0;
+
+    if (length > 0 && CHAR_IS(*text, CHAR_SIGN)) {
+        negative = *text == '-';
+        text++;
+        length--;
+    }
+    while (length > 0 && *text == '0') {
+        text++;
+        length--;
+    }
+    if (length > MAX_DATA_DIGITS) {
+        return 0;
+    }
+    for (; length >= 4; text += 4, length -= 4) {
+        magnitude = magnitude * 10000 + convert_four_digits(text);
+    }
+    for (; length > 0; text++, length--) {
+        magnitude = magnitude * 10 + (unsigned long)(*text - '0');
+    }
+    if (negative ? magnitude > (unsigned long)-DATA_MIN : magnitude > (unsigned long)DATA_MAX) {
+        return 0;
+    }
+    *value = negative ? -(long)magnitude : (long)magnitude;
+    return 1;
+}